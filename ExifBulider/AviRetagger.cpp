@@ -0,0 +1,662 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "AviRetagger.h"
+#include "JpegHeader.h"
+
+#ifdef _WIN32
+#define microexif_fseek _fseeki64
+#define microexif_ftell _ftelli64
+#else
+#define microexif_fseek fseeko
+#define microexif_ftell ftello
+#endif
+
+namespace {
+
+constexpr uint32_t fourcc(char a, char b, char c, char d) {
+	return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8)
+		| (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+}
+
+constexpr uint32_t fccRIFF = fourcc('R', 'I', 'F', 'F');
+constexpr uint32_t fccLIST = fourcc('L', 'I', 'S', 'T');
+constexpr uint32_t fccMovi = fourcc('m', 'o', 'v', 'i');
+constexpr uint32_t fccIdx1 = fourcc('i', 'd', 'x', '1');
+constexpr uint32_t fccIndx = fourcc('i', 'n', 'd', 'x');
+constexpr uint32_t fccAvih = fourcc('a', 'v', 'i', 'h');
+constexpr uint32_t fccStrh = fourcc('s', 't', 'r', 'h');
+constexpr uint32_t fccVids = fourcc('v', 'i', 'd', 's');
+
+uint32_t getUInt32(const uint8_t* src) {
+	return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8)
+		| (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+uint64_t getUInt64(const uint8_t* src) {
+	return static_cast<uint64_t>(getUInt32(src)) | (static_cast<uint64_t>(getUInt32(src + 4)) << 32);
+}
+
+void putUInt32(uint8_t* dst, uint32_t value) {
+	ExifBuilder::putUInt32(dst, value, false);
+}
+
+void putUInt64(uint8_t* dst, uint64_t value) {
+	putUInt32(dst, static_cast<uint32_t>(value));
+	putUInt32(dst + 4, static_cast<uint32_t>(value >> 32));
+}
+
+// ix## (standard index) and idx1 chunk IDs are "ix00", "00dc", ...
+bool isStandardIndex(uint32_t id) {
+	return (id & 0xFFFF) == fourcc('i', 'x', 0, 0);
+}
+
+bool isVideoChunk(uint32_t id) {
+	uint32_t type = id >> 16;
+	return type == (fourcc(0, 0, 'd', 'c') >> 16) || type == (fourcc(0, 0, 'd', 'b') >> 16);
+}
+
+// Timestamp of frame index in a stream of rate/scale frames per second
+uint64_t frameOffsetUs(uint64_t index, uint32_t scale, uint32_t rate) {
+	return index * scale * 1000000ull / rate;
+}
+
+// EXIF blob of one frame: the template tags plus DateTimeOriginal and
+// SubSecTimeOriginal at offsetUs after the start of the recording
+ExifError buildFrameBlob(ExifBuilder& tags, std::time_t recordingStart, uint64_t offsetUs, std::vector<uint8_t>& blob) {
+	std::time_t seconds = recordingStart + static_cast<std::time_t>(offsetUs / 1000000);
+	struct tm timeinfo;
+#ifdef _WIN32
+	localtime_s(&timeinfo, &seconds);
+#else
+	localtime_r(&seconds, &timeinfo);
+#endif
+	char timeStr[20];
+	char subSecStr[4];
+	strftime(timeStr, sizeof(timeStr), "%Y:%m:%d %H:%M:%S", &timeinfo);
+	snprintf(subSecStr, sizeof(subSecStr), "%03u", static_cast<unsigned>(offsetUs / 1000 % 1000));
+	tags.setTagString(0x9003, timeStr, std::strlen(timeStr));
+	tags.setTagString(0x9291, subSecStr, 3);
+
+	blob.resize(tags.exifBlobSize());
+	return tags.buildExifBlobInto(blob.data(), blob.size()) == 0 ? ExifError::TooLarge : ExifError::None;
+}
+
+// Part of the frame the blob replaces: an existing EXIF segment, otherwise
+// the empty range at the insertion point. True if a segment is replaced.
+bool findExifRange(const uint8_t* frame, const JpegHeaderLayout& layout, size_t& cutBegin, size_t& cutEnd) {
+	cutBegin = cutEnd = layout.insertOffset;
+	for (const auto& segment : layout.segments) {
+		if (isJpegAppSegment(frame, segment, 0xE1, "Exif\0", 6)) {
+			cutBegin = segment.offset;
+			cutEnd = segment.offset + segment.length;
+			return true;
+		}
+	}
+	return false;
+}
+
+class AviRetagger {
+public:
+	AviRetagger(const ExifBuilder& tags, std::time_t recordingStart)
+		: frameTags(tags), recordingStart(recordingStart) {}
+
+	ExifResult<AviRetagStats> run(const std::string& inputFile, const std::string& outputFile);
+
+private:
+	// Position of a chunk (its 8-byte header) before and after re-tagging
+	struct Moved {
+		uint64_t oldOffset;
+		uint64_t newOffset;
+		uint32_t newSize;
+	};
+
+	// Chunk that is rewritten once all chunk positions are known
+	struct Deferred {
+		uint32_t id;
+		uint64_t newOffset;
+		std::vector<uint8_t> data;
+	};
+
+	ExifError copyChunks(uint64_t end);
+	ExifError copyChunk(uint32_t id, uint32_t size);
+	ExifError retagFrame(uint32_t id);
+	ExifError rewriteIdx1();
+	ExifError finishDeferred();
+
+	bool read(void* data, size_t size) {
+		if (fread(data, 1, size, in) != size) {
+			return false;
+		}
+		inPos += size;
+		return true;
+	}
+
+	bool write(const void* data, size_t size) {
+		if (fwrite(data, 1, size, out) != size) {
+			return false;
+		}
+		outPos += size;
+		return true;
+	}
+
+	bool patchUInt32(uint64_t offset, uint32_t value) {
+		uint8_t bytes[4];
+		putUInt32(bytes, value);
+		return microexif_fseek(out, static_cast<int64_t>(offset), SEEK_SET) == 0 && fwrite(bytes, 1, 4, out) == 4
+			&& microexif_fseek(out, static_cast<int64_t>(outPos), SEEK_SET) == 0;
+	}
+
+	// New position of the chunk whose old header was at oldOffset
+	const Moved* lookup(uint64_t oldOffset) const {
+		auto it = std::lower_bound(moved.begin(), moved.end(), oldOffset,
+			[](const Moved& m, uint64_t offset) { return m.oldOffset < offset; });
+		if (it == moved.end() || it->oldOffset != oldOffset) {
+			return nullptr;
+		}
+		return &*it;
+	}
+
+	// Timestamp of the video chunk with the given index, in one step so that
+	// rates like 30000/1001 do not drift
+	uint64_t frameTimeUs(uint64_t index) const {
+		if (streamRate != 0 && streamScale != 0) {
+			return frameOffsetUs(index, streamScale, streamRate);
+		}
+		return index * microSecPerFrame;
+	}
+
+	ExifBuilder frameTags;
+	std::time_t recordingStart;
+
+	FILE* in = nullptr;
+	FILE* out = nullptr;
+	uint64_t inPos = 0;
+	uint64_t outPos = 0;
+	uint64_t inSize = 0;
+
+	std::vector<Moved> moved;           // Every chunk and LIST (idx1 may list "rec " LISTs), in file order
+	std::vector<Deferred> deferred;
+	uint64_t moviOldOffset = 0;         // Offset of the "movi" type of the current RIFF
+	uint64_t moviNewOffset = 0;
+	uint32_t lastStreamType = 0;        // fccType of the last strh
+	uint32_t microSecPerFrame = 0;
+	uint32_t streamScale = 0;
+	uint32_t streamRate = 0;
+	uint32_t maxChunkSize = 0;
+	uint32_t chunkSize = 0;             // Size of the chunk written last
+	size_t videoChunks = 0;             // Including dropped (empty) frames, for the timestamps
+
+	std::vector<uint8_t> frame;         // Reused buffers
+	std::vector<uint8_t> blob;
+	AviRetagStats stats;
+};
+
+ExifResult<AviRetagStats> AviRetagger::run(const std::string& inputFile, const std::string& outputFile) {
+	in = fopen(inputFile.c_str(), "rb");
+	if (!in) {
+		return ExifResult<AviRetagStats>::failure(ExifError::OpenFailed);
+	}
+	out = fopen(outputFile.c_str(), "w+b");
+	if (!out) {
+		fclose(in);
+		return ExifResult<AviRetagStats>::failure(ExifError::CreateFailed);
+	}
+	setvbuf(in, nullptr, _IOFBF, 1 << 20);
+	setvbuf(out, nullptr, _IOFBF, 1 << 20);
+	if (microexif_fseek(in, 0, SEEK_END) == 0) {
+		inSize = static_cast<uint64_t>(microexif_ftell(in));
+	}
+	microexif_fseek(in, 0, SEEK_SET);
+
+	// The file is a sequence of RIFF chunks ("AVI " and OpenDML "AVIX")
+	ExifError error = ExifError::None;
+	uint8_t header[12];
+	for (;;) {
+		size_t n = fread(header, 1, 12, in);
+		if (n == 0) {
+			break;
+		}
+		inPos += n;
+		if (n != 12 || getUInt32(header) != fccRIFF) {
+			error = stats.frames == 0 && moved.empty() ? ExifError::Malformed : ExifError::Truncated;
+			break;
+		}
+		uint64_t end = inPos - 4 + getUInt32(header + 4);
+		uint64_t riffStart = outPos;
+		if (!write(header, 12)) {
+			error = ExifError::WriteFailed;
+			break;
+		}
+		error = copyChunks(end);
+		if (error != ExifError::None) {
+			break;
+		}
+		if (outPos - riffStart - 8 > UINT32_MAX || !patchUInt32(riffStart + 4, static_cast<uint32_t>(outPos - riffStart - 8))) {
+			error = ExifError::WriteFailed;
+			break;
+		}
+	}
+	if (error == ExifError::None) {
+		error = finishDeferred();
+	}
+
+	fclose(in);
+	bool closed = fclose(out) == 0;
+	if (error == ExifError::None && !closed) {
+		error = ExifError::WriteFailed;
+	}
+	if (error != ExifError::None) {
+		return ExifResult<AviRetagStats>::failure(error, static_cast<size_t>(inPos));
+	}
+	return ExifResult<AviRetagStats>::success(stats);
+}
+
+// Copies the chunks up to the input offset end, descending into LISTs
+ExifError AviRetagger::copyChunks(uint64_t end) {
+	while (inPos + 8 <= end) {
+		uint8_t header[8];
+		uint64_t oldOffset = inPos;
+		if (!read(header, 8)) {
+			return ExifError::Truncated;
+		}
+		uint32_t id = getUInt32(header);
+		uint32_t size = getUInt32(header + 4);
+		// Sizes are checked before any buffer is allocated for the chunk
+		if (inPos + size > end) {
+			return ExifError::Malformed;
+		}
+		if (inPos + size > inSize) {
+			return ExifError::Truncated;
+		}
+
+		if (id == fccLIST) {
+			uint8_t type[4];
+			if (size < 4 || !read(type, 4)) {
+				return ExifError::Malformed;
+			}
+			uint64_t listStart = outPos;
+			if (!write(header, 8) || !write(type, 4)) {
+				return ExifError::WriteFailed;
+			}
+			if (getUInt32(type) == fccMovi) {
+				moviOldOffset = oldOffset + 8;
+				moviNewOffset = listStart + 8;
+			}
+			// The LIST precedes its chunks in moved, its size is known at the end
+			size_t slot = moved.size();
+			moved.push_back({ oldOffset, listStart, 0 });
+			ExifError error = copyChunks(oldOffset + 8 + size);
+			if (error != ExifError::None) {
+				return error;
+			}
+			if (outPos - listStart - 8 > UINT32_MAX || !patchUInt32(listStart + 4, static_cast<uint32_t>(outPos - listStart - 8))) {
+				return ExifError::WriteFailed;
+			}
+			moved[slot].newSize = static_cast<uint32_t>(outPos - listStart - 8);
+		}
+		else {
+			uint64_t newOffset = outPos;
+			chunkSize = size;
+			ExifError error = copyChunk(id, size);
+			if (error != ExifError::None) {
+				return error;
+			}
+			moved.push_back({ oldOffset, newOffset, chunkSize });
+		}
+
+		// Chunks are padded to an even size
+		if (size % 2 != 0 && inPos < end) {
+			uint8_t pad;
+			if (!read(&pad, 1)) {
+				return ExifError::Truncated;
+			}
+		}
+	}
+
+	// Skip a stray odd byte at the end of a list
+	while (inPos < end) {
+		uint8_t pad;
+		if (!read(&pad, 1)) {
+			return ExifError::Truncated;
+		}
+	}
+	return ExifError::None;
+}
+
+ExifError AviRetagger::copyChunk(uint32_t id, uint32_t size) {
+	if (isVideoChunk(id) && moviOldOffset != 0) {
+		frame.resize(size);
+		if (!read(frame.data(), size)) {
+			return ExifError::Truncated;
+		}
+		return retagFrame(id);
+	}
+
+	if (id == fccIdx1) {
+		frame.resize(size);
+		if (!read(frame.data(), size)) {
+			return ExifError::Truncated;
+		}
+		return rewriteIdx1();
+	}
+
+	uint8_t header[8];
+	putUInt32(header, id);
+	putUInt32(header + 4, size);
+	if (!write(header, 8)) {
+		return ExifError::WriteFailed;
+	}
+
+	// Headers and indexes that reference later chunks are kept for the final patch
+	if (id == fccIndx || isStandardIndex(id) || id == fccAvih || id == fccStrh) {
+		Deferred patch{ id, outPos - 8, std::vector<uint8_t>(size) };
+		if (!read(patch.data.data(), size)) {
+			return ExifError::Truncated;
+		}
+		if (id == fccAvih && size >= 4) {
+			microSecPerFrame = getUInt32(patch.data.data());
+		}
+		if (id == fccStrh && size >= 28) {
+			lastStreamType = getUInt32(patch.data.data());
+			if (lastStreamType == fccVids && streamRate == 0) {
+				streamScale = getUInt32(patch.data.data() + 20);
+				streamRate = getUInt32(patch.data.data() + 24);
+			}
+		}
+		bool written = write(patch.data.data(), size) && (size % 2 == 0 || write("", 1));
+		deferred.push_back(std::move(patch));
+		return written ? ExifError::None : ExifError::WriteFailed;
+	}
+
+	uint8_t buffer[64 * 1024];
+	uint32_t left = size;
+	while (left > 0) {
+		uint32_t n = std::min<uint32_t>(left, sizeof(buffer));
+		if (!read(buffer, n)) {
+			return ExifError::Truncated;
+		}
+		if (!write(buffer, n)) {
+			return ExifError::WriteFailed;
+		}
+		left -= n;
+	}
+	return size % 2 == 0 || write("", 1) ? ExifError::None : ExifError::WriteFailed;
+}
+
+ExifError AviRetagger::retagFrame(uint32_t id) {
+	JpegHeaderLayout layout;
+	size_t cutBegin = 0;
+	size_t cutEnd = 0;
+	bool isJpeg = scanJpegHeader(frame.data(), frame.size(), layout).error == ExifError::None;
+
+	if (isJpeg) {
+		// Timestamp of this frame, relative to the start of the recording
+		uint64_t offsetUs = frameTimeUs(videoChunks);
+		ExifError error = buildFrameBlob(frameTags, recordingStart, offsetUs, blob);
+		if (error != ExifError::None) {
+			return error;
+		}
+		// Replace an existing EXIF segment in place, otherwise insert
+		if (findExifRange(frame.data(), layout, cutBegin, cutEnd)) {
+			++stats.replaced;
+		}
+		++stats.frames;
+	}
+	else {
+		blob.clear();
+		++stats.skipped;
+	}
+	++videoChunks;
+
+	uint64_t newSize = frame.size() - (cutEnd - cutBegin) + blob.size();
+	if (newSize > UINT32_MAX) {
+		return ExifError::TooLarge;
+	}
+	chunkSize = static_cast<uint32_t>(newSize);
+	maxChunkSize = std::max(maxChunkSize, chunkSize);
+
+	uint8_t header[8];
+	putUInt32(header, id);
+	putUInt32(header + 4, static_cast<uint32_t>(newSize));
+	bool written = write(header, 8)
+		&& write(frame.data(), cutBegin)
+		&& write(blob.data(), blob.size())
+		&& write(frame.data() + cutEnd, frame.size() - cutEnd)
+		&& (newSize % 2 == 0 || write("", 1));
+	return written ? ExifError::None : ExifError::WriteFailed;
+}
+
+// idx1 follows the movi list of its RIFF, so all its chunks have been moved.
+// Entries: ckid, flags, offset (of the chunk header, relative to "movi" or
+// absolute), size.
+ExifError AviRetagger::rewriteIdx1() {
+	size_t count = frame.size() / 16;
+	bool relative = count == 0 || lookup(moviOldOffset + getUInt32(frame.data() + 8)) != nullptr;
+
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t* entry = frame.data() + i * 16;
+		const Moved* chunk = lookup(getUInt32(entry + 8) + (relative ? moviOldOffset : 0));
+		if (chunk) {
+			putUInt32(entry + 8, static_cast<uint32_t>(chunk->newOffset - (relative ? moviNewOffset : 0)));
+			putUInt32(entry + 12, chunk->newSize);
+		}
+	}
+
+	uint8_t header[8];
+	putUInt32(header, fccIdx1);
+	putUInt32(header + 4, static_cast<uint32_t>(frame.size()));
+	bool written = write(header, 8) && write(frame.data(), frame.size()) && (frame.size() % 2 == 0 || write("", 1));
+	return written ? ExifError::None : ExifError::WriteFailed;
+}
+
+// Rewrites the OpenDML indexes and the stream headers with the final positions
+ExifError AviRetagger::finishDeferred() {
+	for (auto& patch : deferred) {
+		uint8_t* data = patch.data.data();
+		size_t size = patch.data.size();
+
+		if (patch.id == fccIndx && size >= 24 && data[3] == 0x00) {
+			// Super index: qwOffset, dwSize, dwDuration of every ix## chunk
+			size_t entries = std::min<size_t>(getUInt32(data + 4), (size - 24) / 16);
+			for (size_t i = 0; i < entries; ++i) {
+				uint8_t* entry = data + 24 + i * 16;
+				const Moved* chunk = lookup(getUInt64(entry));
+				if (chunk) {
+					putUInt64(entry, chunk->newOffset);
+				}
+			}
+		}
+		else if (isStandardIndex(patch.id) && size >= 24 && data[3] == 0x01) {
+			// Standard index: dwOffset (of the chunk data, relative to
+			// qwBaseOffset) and dwSize with the keyframe bit of every chunk
+			size_t entries = std::min<size_t>(getUInt32(data + 4), (size - 24) / 8);
+			uint64_t oldBase = getUInt64(data + 12);
+			std::vector<const Moved*> chunks(entries);
+			uint64_t newBase = UINT64_MAX;
+			for (size_t i = 0; i < entries; ++i) {
+				chunks[i] = lookup(oldBase + getUInt32(data + 24 + i * 8) - 8);
+				if (chunks[i]) {
+					newBase = std::min(newBase, chunks[i]->newOffset + 8);
+				}
+			}
+			if (newBase == UINT64_MAX) {
+				continue;
+			}
+			putUInt64(data + 12, newBase);
+			for (size_t i = 0; i < entries; ++i) {
+				uint8_t* entry = data + 24 + i * 8;
+				if (chunks[i]) {
+					putUInt32(entry, static_cast<uint32_t>(chunks[i]->newOffset + 8 - newBase));
+					putUInt32(entry + 4, (getUInt32(entry + 4) & 0x80000000u) | chunks[i]->newSize);
+				}
+			}
+		}
+		else if (patch.id == fccAvih && size >= 32) {
+			putUInt32(data + 28, std::max(getUInt32(data + 28), maxChunkSize));
+		}
+		else if (patch.id == fccStrh && size >= 40 && getUInt32(data) == fccVids) {
+			putUInt32(data + 36, std::max(getUInt32(data + 36), maxChunkSize));
+		}
+		else {
+			continue;
+		}
+
+		if (microexif_fseek(out, static_cast<int64_t>(patch.newOffset + 8), SEEK_SET) != 0 || fwrite(data, 1, size, out) != size) {
+			return ExifError::WriteFailed;
+		}
+	}
+	return ExifError::None;
+}
+
+// Copies size bytes from the current position of in to out
+bool copyBytes(FILE* in, FILE* out, uint64_t size) {
+	uint8_t buffer[64 * 1024];
+	while (size > 0) {
+		size_t n = static_cast<size_t>(std::min<uint64_t>(size, sizeof(buffer)));
+		if (fread(buffer, 1, n, in) != n || fwrite(buffer, 1, n, out) != n) {
+			return false;
+		}
+		size -= n;
+	}
+	return true;
+}
+
+} // namespace
+
+ExifResult<AviRetagStats> retagMjpegFile(const std::string& inputFile, const std::string& outputFile,
+	const std::vector<MjpegFrameInfo>& frames, const ExifBuilder& tags, std::time_t recordingStart,
+	uint32_t rate, uint32_t scale, std::vector<MjpegFrameInfo>* retagged) {
+	using Result = ExifResult<AviRetagStats>;
+	if (rate == 0 || scale == 0) {
+		return Result::failure(ExifError::Malformed);
+	}
+	FILE* in = fopen(inputFile.c_str(), "rb");
+	if (!in) {
+		return Result::failure(ExifError::OpenFailed);
+	}
+	uint64_t inSize = 0;
+	if (microexif_fseek(in, 0, SEEK_END) == 0) {
+		inSize = static_cast<uint64_t>(microexif_ftell(in));
+	}
+	microexif_fseek(in, 0, SEEK_SET);
+
+	// The table must describe this file: frames in order, not overlapping
+	uint64_t tableEnd = 0;
+	for (const auto& info : frames) {
+		if (info.offset < tableEnd || info.offset + info.size > inSize) {
+			fclose(in);
+			return Result::failure(ExifError::Malformed, static_cast<size_t>(info.offset));
+		}
+		tableEnd = info.offset + info.size;
+	}
+	FILE* out = fopen(outputFile.c_str(), "wb");
+	if (!out) {
+		fclose(in);
+		return Result::failure(ExifError::CreateFailed);
+	}
+	setvbuf(in, nullptr, _IOFBF, 1 << 20);
+	setvbuf(out, nullptr, _IOFBF, 1 << 20);
+
+	ExifBuilder frameTags(tags);
+	AviRetagStats stats;
+	std::vector<uint8_t> frame;
+	std::vector<uint8_t> blob;
+	JpegHeaderLayout layout;
+	ExifError error = ExifError::None;
+	uint64_t inPos = 0;
+	uint64_t outPos = 0;
+	if (retagged) {
+		retagged->clear();
+	}
+	for (size_t i = 0; i < frames.size() && error == ExifError::None; ++i) {
+		const MjpegFrameInfo& info = frames[i];
+		// Bytes between frames are kept as they are
+		frame.resize(info.size);
+		if (!copyBytes(in, out, info.offset - inPos) || fread(frame.data(), 1, frame.size(), in) != frame.size()) {
+			error = ExifError::ReadFailed;
+			break;
+		}
+		outPos += info.offset - inPos;
+		inPos = info.offset + info.size;
+
+		size_t cutBegin = 0;
+		size_t cutEnd = 0;
+		layout.reset();
+		if (scanJpegHeader(frame.data(), frame.size(), layout)) {
+			error = buildFrameBlob(frameTags, recordingStart, frameOffsetUs(i, scale, rate), blob);
+			if (findExifRange(frame.data(), layout, cutBegin, cutEnd)) {
+				++stats.replaced;
+			}
+			++stats.frames;
+		}
+		else {
+			blob.clear();
+			++stats.skipped;
+		}
+
+		uint64_t newSize = frame.size() - (cutEnd - cutBegin) + blob.size();
+		if (error == ExifError::None && newSize > UINT32_MAX) {
+			error = ExifError::TooLarge;
+		}
+		if (error != ExifError::None) {
+			break;
+		}
+		bool written = fwrite(frame.data(), 1, cutBegin, out) == cutBegin
+			&& fwrite(blob.data(), 1, blob.size(), out) == blob.size()
+			&& fwrite(frame.data() + cutEnd, 1, frame.size() - cutEnd, out) == frame.size() - cutEnd;
+		if (!written) {
+			error = ExifError::WriteFailed;
+			break;
+		}
+		if (retagged) {
+			retagged->push_back({ outPos, static_cast<uint32_t>(newSize), info.flags, info.timestampUs });
+		}
+		outPos += newSize;
+	}
+	if (error == ExifError::None && !copyBytes(in, out, inSize - inPos)) {
+		error = ExifError::ReadFailed;
+	}
+
+	fclose(in);
+	bool closed = fclose(out) == 0;
+	if (error == ExifError::None && !closed) {
+		error = ExifError::WriteFailed;
+	}
+	if (error != ExifError::None) {
+		return Result::failure(error, static_cast<size_t>(inPos));
+	}
+	return Result::success(stats);
+}
+
+ExifResult<AviRetagStats> retagAviFile(const std::string& inputFile, const std::string& outputFile,
+	const ExifBuilder& tags, std::time_t recordingStart) {
+	AviRetagger retagger(tags, recordingStart);
+	return retagger.run(inputFile, outputFile);
+}
@@ -0,0 +1,67 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "MicroExif.h"
+#include "MjpegRecording.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// AVI re-tagger:
+//
+// Copies an MJPEG AVI (AVI 1.0 or OpenDML) and injects or replaces the EXIF
+// APP1 segment of every video frame in one sequential pass over the input.
+//
+// - Every frame gets the tags of the template builder plus its own
+//   DateTimeOriginal (0x9003) and SubSecTimeOriginal (0x9291), computed from
+//   recordingStart and the frame rate of the video stream.
+// - Chunk, LIST and RIFF sizes are rewritten as the frames grow or shrink.
+// - The idx1 index, the OpenDML standard indexes (ix##) and super indexes
+//   (indx) are regenerated for the new chunk positions, and the suggested
+//   buffer sizes in avih/strh are raised if a frame got larger.
+//
+// Headers that precede the data (indx, avih, strh) are patched in the output
+// once the pass is done; their sizes never change.
+//
+struct AviRetagStats {
+    size_t frames = 0;          // Video frames that were re-tagged
+    size_t replaced = 0;        // Frames that already had an EXIF segment
+    size_t skipped = 0;         // Video chunks that are not JPEG frames
+};
+
+ExifResult<AviRetagStats> retagAviFile(const std::string& inputFile, const std::string& outputFile,
+    const ExifBuilder& tags, std::time_t recordingStart);
+
+// Raw MJPEG (concatenated JPEGs without a container, see MjpegIndexer.h):
+// copies the file and re-tags every frame of the table the same way. The
+// timestamps follow the frame number in the table at rate/scale frames per
+// second; bytes outside the frames are copied unchanged. If retagged is
+// given, it receives the table of the output file.
+ExifResult<AviRetagStats> retagMjpegFile(const std::string& inputFile, const std::string& outputFile,
+    const std::vector<MjpegFrameInfo>& frames, const ExifBuilder& tags, std::time_t recordingStart,
+    uint32_t rate, uint32_t scale = 1, std::vector<MjpegFrameInfo>* retagged = nullptr);
@@ -0,0 +1,268 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include "BatchTagger.h"
+
+BatchTagger::BatchTagger(const uint8_t* exifBlob, size_t exifSize, const BatchOptions& options)
+	: blob(exifBlob), blobSize(exifSize), queueDepth(std::max<size_t>(1, options.queueDepth)), placement(options.placement),
+	backend(options.backend), adaptive(options.adaptive), frontLoad(options.frontLoad), frontLoadOptions(options.frontLoadOptions),
+	tagsForFile(options.tagsForFile), blobCache(options.blobCache ? options.blobCache : &exifBlobCache()),
+	durable(options.durable), byteOrder(options.byteOrder) {
+	if (durable) {
+		durableFailed = durable->stats().failed;
+	}
+	unsigned count = options.workers ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+	activeLimit = count;
+	if (adaptive) {
+		count = std::max(count, options.maxWorkers ? options.maxWorkers : count * 2);
+	}
+	intervalStart = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < count; ++i) {
+		workers.emplace_back(&BatchTagger::work, this, i);
+	}
+}
+
+BatchTagger::~BatchTagger() {
+	finish();
+}
+
+void BatchTagger::submit(std::string input, std::string output) {
+	std::unique_lock<std::mutex> lock(mutex);
+	spaceAvailable.wait(lock, [&]() { return jobs.size() < queueDepth || stopping; });
+	if (stopping) {
+		return;
+	}
+	jobs.emplace_back(std::move(input), std::move(output));
+	++stats.submitted;
+	// A parked worker could swallow a single wakeup
+	if (workers.size() > activeLimit) {
+		jobAvailable.notify_all();
+	}
+	else {
+		jobAvailable.notify_one();
+	}
+}
+
+BatchStats BatchTagger::finish() {
+	// Also called from the destructor, the durable counts must not be applied twice
+	if (finished) {
+		return stats;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	spaceAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	if (durable) {
+		durable->commit();
+		size_t unpublished = durable->stats().failed - durableFailed;
+		stats.tagged -= unpublished;
+		stats.failed += unpublished;
+		stats.errors[static_cast<size_t>(ExifError::WriteFailed)] += unpublished;
+	}
+	stats.activeWorkers = activeLimit;
+	finished = true;
+	return stats;
+}
+
+void BatchTagger::work(unsigned index) {
+	applyThreadPlacement(placement, index);
+
+	std::string lastDirectory;
+	ExifBuilder tags;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		// Workers above the active limit stay parked until it grows
+		jobAvailable.wait(lock, [&]() { return (!jobs.empty() && index < activeLimit) || (stopping && jobs.empty()); });
+		if (jobs.empty()) {
+			break;
+		}
+		auto job = std::move(jobs.front());
+		jobs.pop_front();
+		spaceAvailable.notify_one();
+		if (stopping && jobs.empty()) {
+			// Lets parked workers see that the queue has drained
+			jobAvailable.notify_all();
+		}
+		lock.unlock();
+
+		// Files of one directory usually arrive together
+		std::filesystem::path directory = std::filesystem::path(job.second).parent_path();
+		if (!directory.empty() && directory.native() != lastDirectory) {
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+			lastDirectory = directory.native();
+		}
+		const uint8_t* exifBlob = blob;
+		size_t exifSize = blobSize;
+		ExifBlobCache::Blob shared;
+		if (tagsForFile && byteOrder == ExifByteOrder::Keep) {
+			tags.clear();
+			if (!tagsForFile(job.first, tags)) {
+				lock.lock();
+				++stats.skipped;
+				continue;
+			}
+			shared = blobCache->get(tags);
+			exifBlob = shared ? shared->data() : nullptr;
+			exifSize = shared ? shared->size() : 0;
+		}
+
+		ExifResult<size_t> result;
+		bool beyondLimit = false;
+		bool converted = false;
+		if (byteOrder != ExifByteOrder::Keep) {
+			auto report = normalizeJpegByteOrder(job.first, job.second, byteOrder == ExifByteOrder::BigEndian);
+			result = report ? ExifResult<size_t>::success(report.value.fileSize) : ExifResult<size_t>::failure(report.error, report.offset);
+			converted = report && report.value.segments != 0;
+		}
+		else if (!exifBlob) {
+			result = ExifResult<size_t>::failure(ExifError::TooLarge);
+		}
+		else if (frontLoad) {
+			auto report = writeFrontLoadedJpeg(job.first, job.second, exifBlob, exifSize, frontLoadOptions);
+			result = report ? ExifResult<size_t>::success(report.value.fileSize) : ExifResult<size_t>::failure(report.error, report.offset);
+			beyondLimit = report && !report.value.withinLimit;
+		}
+		else if (durable) {
+			result = writeDurableJpegWithExif(job.first, job.second, exifBlob, exifSize, *durable);
+		}
+		else {
+			result = injectExifFile(job.first, job.second, exifBlob, exifSize, backend);
+		}
+
+		lock.lock();
+		if (result) {
+			++stats.tagged;
+			stats.bytesWritten += result.value;
+			stats.exifBeyondLimit += beyondLimit ? 1 : 0;
+			stats.converted += converted ? 1 : 0;
+		}
+		else {
+			++stats.failed;
+			++stats.errors[static_cast<size_t>(result.error)];
+		}
+		if (adaptive) {
+			++intervalCompleted;
+			adapt();
+		}
+	}
+}
+
+// Called with the mutex held after every job
+void BatchTagger::adapt() {
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration<double>(now - intervalStart).count();
+	if (elapsed < 0.25) {
+		return;
+	}
+	double rate = static_cast<double>(intervalCompleted) / elapsed;
+	// A drop of more than 3% turns the search around, noise below that does not
+	if (lastRate > 0.0 && rate < lastRate * 0.97) {
+		direction = -direction;
+	}
+	lastRate = rate;
+	intervalStart = now;
+	intervalCompleted = 0;
+
+	long limit = static_cast<long>(activeLimit) + direction;
+	if (limit < 1 || limit > static_cast<long>(workers.size())) {
+		direction = -direction;
+		return;
+	}
+	activeLimit = static_cast<unsigned>(limit);
+	jobAvailable.notify_all();
+}
+
+namespace {
+
+// Absolute path without . and .. or symlinks in its existing part and
+// without a trailing separator
+std::filesystem::path normalizedRoot(std::string root) {
+	while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) {
+		root.pop_back();
+	}
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(root, error);
+	return error ? std::filesystem::absolute(root, error).lexically_normal() : path;
+}
+
+bool isWithin(const std::filesystem::path& inner, const std::filesystem::path& outer) {
+	auto innerPart = inner.begin();
+	for (const auto& part : outer) {
+		if (innerPart == inner.end() || *innerPart != part) {
+			return false;
+		}
+		++innerPart;
+	}
+	return true;
+}
+
+} // namespace
+
+bool batchRootsOverlap(const std::string& inputRoot, const std::string& outputRoot) {
+	std::filesystem::path input = normalizedRoot(inputRoot);
+	std::filesystem::path output = normalizedRoot(outputRoot);
+	return isWithin(output, input) || isWithin(input, output);
+}
+
+BatchRunStats tagDirectory(const std::string& inputRoot, const std::string& outputRoot, const uint8_t* exifBlob, size_t exifSize,
+	const BatchOptions& options, const CrawlOptions& crawlOptions) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::string root = inputRoot;
+	while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) {
+		root.pop_back();
+	}
+
+	BatchRunStats run;
+	if (batchRootsOverlap(root, outputRoot)) {
+		run.error = ExifError::CreateFailed;
+		return run;
+	}
+	NumaCounters numaBefore;
+	run.numaAvailable = NumaCounters::read(numaBefore);
+
+	BatchTagger tagger(exifBlob, exifSize, options);
+	run.crawl = crawlDirectory(root, crawlOptions, [&](std::string&& path) {
+		// The crawler reports paths below root, keep the relative part
+		std::string output = outputRoot + path.substr(root.size());
+		tagger.submit(std::move(path), std::move(output));
+	});
+	run.batch = tagger.finish();
+	if (run.numaAvailable && NumaCounters::read(run.numa)) {
+		run.numa = run.numa - numaBefore;
+	}
+	run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return run;
+}
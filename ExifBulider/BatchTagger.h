@@ -0,0 +1,177 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "DurableWriter.h"
+#include "ExifBlobCache.h"
+#include "ExifTranscoder.h"
+#include "FileCrawler.h"
+#include "FrontLoader.h"
+#include "IoBackends.h"
+#include "MicroExif.h"
+#include "ThreadPlacement.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// BatchTagger:
+//
+// Pool of injector threads that tag files with one EXIF blob. Jobs (input
+// and output path) are queued with submit(), which blocks while the queue is
+// full, so a fast producer such as the crawler cannot run ahead of the disks
+// by more than queueDepth files. Missing output directories are created.
+//
+// tagDirectory() connects crawlDirectory() to a BatchTagger: every JPEG
+// below inputRoot is written to the same relative path below outputRoot,
+// and tagging starts as soon as the first file has been discovered. Roots
+// that overlap are rejected before anything is read.
+//
+// Worker i pins itself with applyThreadPlacement(options.placement, i)
+// before it takes the first job, so the buffers it allocates for the files
+// are first touched, and therefore placed, on its own node.
+//
+// Files can get their own tags through tagsForFile. The blob for each tag
+// set is then taken from an ExifBlobCache (the process-wide one unless
+// blobCache is set), so files sharing a tag set share one blob.
+//
+// With adaptive set, maxWorkers threads are started but only a varying
+// number of them take jobs: every quarter second the completed-file rate is
+// compared with the previous interval, and the limit keeps moving by one
+// worker in the same direction while the rate improves and turns around
+// when it drops. This follows the optimum when the volume slows down.
+//
+// With durable set, plain injections go through the DurableWriter instead
+// of the backend, and finish() commits them. Files the writer could not
+// publish are moved from tagged to failed (as WriteFailed), so when
+// finish() returns every file counted as tagged is on disk under its name.
+// The counts assume that nothing else uses the writer during the run.
+//
+// With byteOrder set the workers do not add the blob but convert the EXIF
+// segments already in the files to that order (normalizeJpegByteOrder()).
+//
+struct BatchOptions {
+    unsigned workers = 0;                   // 0 = one per core
+    size_t queueDepth = 4096;
+    ThreadPlacement placement;
+    IoBackend backend = IoBackend::Stream;
+    bool adaptive = false;                  // Adjust the number of active workers during the run
+    unsigned maxWorkers = 0;                // Upper bound for adaptive, 0 = twice the workers
+    bool frontLoad = false;                 // Reorder the header with writeFrontLoadedJpeg()
+    FrontLoadOptions frontLoadOptions;
+    // Fills the tags of one input file, false skips the file. Called
+    // concurrently from the workers; the builder is cleared before.
+    std::function<bool(const std::string& input, ExifBuilder& tags)> tagsForFile;
+    ExifBlobCache* blobCache = nullptr;
+    DurableWriter* durable = nullptr;       // Crash-safe output, not used with frontLoad
+    ExifByteOrder byteOrder = ExifByteOrder::Keep;
+};
+
+struct BatchStats {
+    size_t submitted = 0;
+    size_t tagged = 0;
+    size_t failed = 0;
+    size_t skipped = 0;                     // Rejected by tagsForFile
+    uint64_t bytesWritten = 0;
+    size_t errors[exifErrorCount] = {};     // Failures by ExifError
+    unsigned activeWorkers = 0;             // At the end of the run
+    size_t exifBeyondLimit = 0;             // Front-loaded files whose EXIF ends after the limit
+    size_t converted = 0;                   // Files whose EXIF changed byte order
+};
+
+class BatchTagger {
+public:
+    // The blob must stay valid until finish() returns, it is not used with tagsForFile
+    BatchTagger(const uint8_t* exifBlob, size_t exifSize, const BatchOptions& options = BatchOptions());
+    ~BatchTagger();
+
+    BatchTagger(const BatchTagger&) = delete;
+    BatchTagger& operator=(const BatchTagger&) = delete;
+
+    // Thread-safe, blocks while the queue is full
+    void submit(std::string input, std::string output);
+    // Waits for all queued jobs and stops the workers, later calls only
+    // return the stats
+    BatchStats finish();
+
+private:
+    void work(unsigned index);
+    void adapt();
+
+    const uint8_t* blob;
+    size_t blobSize;
+    size_t queueDepth;
+    ThreadPlacement placement;
+    IoBackend backend;
+    bool adaptive;
+    bool frontLoad;
+    FrontLoadOptions frontLoadOptions;
+    std::function<bool(const std::string&, ExifBuilder&)> tagsForFile;
+    ExifBlobCache* blobCache;
+    DurableWriter* durable;
+    size_t durableFailed = 0;               // Writer failures before the run
+    ExifByteOrder byteOrder;
+
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable spaceAvailable;
+    std::deque<std::pair<std::string, std::string>> jobs;
+    bool stopping = false;
+    bool finished = false;
+    unsigned activeLimit = 0;
+    BatchStats stats;
+
+    // Adaptive concurrency
+    std::chrono::steady_clock::time_point intervalStart;
+    size_t intervalCompleted = 0;
+    double lastRate = 0.0;
+    int direction = 1;
+
+    std::vector<std::thread> workers;
+};
+
+struct BatchRunStats {
+    ExifError error = ExifError::None;      // CreateFailed if the roots overlap, nothing is tagged then
+    CrawlStats crawl;
+    BatchStats batch;
+    double seconds = 0.0;
+    bool numaAvailable = false;
+    NumaCounters numa;                      // System-wide counters during the run
+};
+
+// True if one root is the other or lies below it, after resolving symlinks
+// and relative parts. Tagging in place would truncate the inputs while they
+// are read, and outputs below the input root would be crawled again.
+bool batchRootsOverlap(const std::string& inputRoot, const std::string& outputRoot);
+
+BatchRunStats tagDirectory(const std::string& inputRoot, const std::string& outputRoot, const uint8_t* exifBlob, size_t exifSize,
+    const BatchOptions& options = BatchOptions(), const CrawlOptions& crawlOptions = CrawlOptions());
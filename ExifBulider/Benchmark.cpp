@@ -0,0 +1,506 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ExifBlobCache.h"
+#include "ExifTranscoder.h"
+#include "JpegHeader.h"
+#include "JpegSpliceCache.h"
+#include "MicroExif.h"
+
+namespace {
+
+// Prevents the compiler from dropping the benchmarked work
+volatile uint64_t benchmarkSink = 0;
+
+void consume(uint64_t value) {
+	benchmarkSink = benchmarkSink + value;
+}
+
+// Tag set similar to the one written by the command line tool
+void addBenchmarkTags(ExifBuilder& builder) {
+	builder.addTag(ExifTag(0x010F, 0x0002, "Ximea"));
+	builder.addTag(ExifTag(0x0110, 0x0002, "MX245CG-SY-X4G3-FF"));
+	builder.addTag(ExifTag(0xA434, 0x0002, "F3526-MPT"));
+	builder.addTag(ExifTag(0x829A, 0x0005, 1, 1, 100));
+	builder.addTag(ExifTag(0x829D, 0x0005, 1, 56, 10));
+	builder.addTag(ExifTag(0x8827, 0x0003, 1, uint16_t(200)));
+	builder.addTag(ExifTag(0x920A, 0x0005, 1, 35, 1));
+	builder.addTag(ExifTag(0xA405, 0x0003, 1, uint16_t(79)));
+	builder.addTag(ExifTag(0x9003, 0x0002, "2025:01:01 12:00:00"));
+	builder.addTag(ExifTag(0x9004, 0x0002, "2025:01:01 12:00:00"));
+	builder.addTag(ExifTag(0x0131, 0x0002, "V Capture"));
+	builder.addTag(ExifTag(0x0112, 0x0003, 1, uint16_t(8)));
+	builder.addTag(ExifTag(0x8298, 0x0002, "2024 Vlad Erium, Japan"));
+}
+
+// Minimal JPEG header with a large APP2 segment in front of the DQT marker,
+// so that the marker search has to walk over typical ICC profile sizes.
+std::vector<uint8_t> makeSyntheticJpeg() {
+	std::vector<uint8_t> jpeg = { 0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00 };
+	const size_t app2Size = 60000;
+	jpeg.insert(jpeg.end(), { 0xFF, 0xE2, static_cast<uint8_t>((app2Size + 2) >> 8), static_cast<uint8_t>((app2Size + 2) & 0xFF) });
+	for (size_t i = 0; i < app2Size; ++i) {
+		jpeg.push_back(static_cast<uint8_t>(i * 131 % 251));
+	}
+	jpeg.insert(jpeg.end(), { 0xFF, 0xDB, 0x00, 0x43, 0x00 });
+	jpeg.insert(jpeg.end(), 64, 0x01);
+	jpeg.insert(jpeg.end(), { 0xFF, 0xD9 });
+	return jpeg;
+}
+
+// Median and distribution-free 95% confidence interval of the median: the
+// interval between the order statistics k and n + 1 - k, where k is the
+// largest rank with P(Binomial(n, 1/2) < k) <= 2.5%.
+void setMedianAndInterval(BenchmarkResult& result) {
+	std::vector<double> sorted = result.samples;
+	std::sort(sorted.begin(), sorted.end());
+	const size_t n = sorted.size();
+	if (n == 0) {
+		return;
+	}
+	result.nsPerOp = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+	size_t k = 0;
+	double cumulative = 0.0;
+	for (size_t i = 0; i < n / 2; ++i) {
+		// P(B = i) = C(n, i) / 2^n, computed in log space to stay finite
+		double logP = std::lgamma(n + 1.0) - std::lgamma(i + 1.0) - std::lgamma(n - i + 1.0) - n * std::log(2.0);
+		cumulative += std::exp(logP);
+		if (cumulative > 0.025) {
+			break;
+		}
+		k = i + 1;
+	}
+	// Too few repetitions for a 95% interval: fall back to the full range
+	result.ciLow = k == 0 ? sorted.front() : sorted[k - 1];
+	result.ciHigh = k == 0 ? sorted.back() : sorted[n - k];
+}
+
+// Frame as written by a typical baseline encoder: JFIF, two quantization
+// tables, SOF0, four Huffman tables and SOS, followed by some scan data
+std::vector<uint8_t> makeEncoderFrame() {
+	std::vector<uint8_t> jpeg = { 0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00 };
+	for (uint8_t table = 0; table < 2; ++table) {
+		jpeg.insert(jpeg.end(), { 0xFF, 0xDB, 0x00, 0x43, table });
+		jpeg.insert(jpeg.end(), 64, static_cast<uint8_t>(table + 2));
+	}
+	jpeg.insert(jpeg.end(), { 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x04, 0x38, 0x07, 0x80, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01 });
+	for (uint8_t table : { 0x00, 0x10, 0x01, 0x11 }) {
+		// 16 code counts followed by 162 symbols, the size of the standard AC tables
+		jpeg.insert(jpeg.end(), { 0xFF, 0xC4, 0x00, 0xB5, table });
+		jpeg.insert(jpeg.end(), 16 + 162, static_cast<uint8_t>(table + 1));
+	}
+	jpeg.insert(jpeg.end(), { 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00 });
+	jpeg.insert(jpeg.end(), 4096, 0x55);
+	jpeg.insert(jpeg.end(), { 0xFF, 0xD9 });
+	return jpeg;
+}
+
+struct Benchmark {
+	std::string name;
+	std::function<void()> body;
+};
+
+// Runs body() for the given number of iterations and returns the elapsed time
+double timeIterations(const Benchmark& benchmark, uint64_t iterations) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < iterations; ++i) {
+		benchmark.body();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+BenchmarkResult runBenchmark(const Benchmark& benchmark, const BenchmarkOptions& options, PerfCounters* counters) {
+	// Calibrate: grow the iteration count until a run takes a measurable time
+	const double minTimeNs = options.minTimeMs * 1e6;
+	uint64_t iterations = 1;
+	double elapsed = timeIterations(benchmark, iterations);
+	while (elapsed < minTimeNs / 10 && iterations < (1ull << 40)) {
+		iterations *= 10;
+		elapsed = timeIterations(benchmark, iterations);
+	}
+	if (elapsed > 0 && elapsed < minTimeNs) {
+		iterations = static_cast<uint64_t>(iterations * (minTimeNs / elapsed)) + 1;
+	}
+
+	BenchmarkResult result;
+	result.name = benchmark.name;
+
+	for (int repetition = 0; repetition < std::max(1, options.repetitions); ++repetition) {
+		if (counters) {
+			counters->start();
+		}
+		elapsed = timeIterations(benchmark, iterations);
+		if (counters) {
+			PerfSample sample = counters->stop();
+			for (int i = 0; i < PerfCounterCount; ++i) {
+				// A counter is only reported if it was readable in every repetition
+				result.counters.valid[i] = sample.valid[i] && (repetition == 0 || result.counters.valid[i]);
+				result.counters.value[i] += sample.value[i];
+			}
+		}
+		result.iterations += iterations;
+		result.samples.push_back(elapsed / static_cast<double>(iterations));
+	}
+
+	setMedianAndInterval(result);
+	return result;
+}
+
+std::vector<Benchmark> makeBenchmarks(const BenchmarkOptions& options) {
+	std::vector<Benchmark> benchmarks;
+
+	benchmarks.push_back({ "buildExifBlob", [] {
+		ExifBuilder builder;
+		addBenchmarkTags(builder);
+		consume(builder.buildExifBlob().size());
+	} });
+
+	auto builder = std::make_shared<ExifBuilder>();
+	addBenchmarkTags(*builder);
+	benchmarks.push_back({ "buildExifBlob/reuse", [builder] {
+		consume(builder->buildExifBlob().size());
+	} });
+
+	auto blobCache = std::make_shared<ExifBlobCache>();
+	benchmarks.push_back({ "ExifBlobCache/hit", [builder, blobCache] {
+		consume(blobCache->get(*builder)->size());
+	} });
+
+	auto segment = std::make_shared<std::vector<uint8_t>>(builder->buildExifBlob());
+	auto transcoded = std::make_shared<std::vector<uint8_t>>(segment->size());
+	benchmarks.push_back({ "transcodeExifSegment", [segment, transcoded] {
+		consume(transcodeExifSegment(segment->data(), segment->size(), transcoded->data(), false).value);
+	} });
+
+	auto jpeg = std::make_shared<std::vector<uint8_t>>(makeSyntheticJpeg());
+	benchmarks.push_back({ "findFFDBMarker/60k", [jpeg] {
+		consume(findFFDBMarker(jpeg->data(), jpeg->size()));
+	} });
+
+	// Header analysis of a complete frame: full segment walk versus cached layout
+	auto frame = std::make_shared<std::vector<uint8_t>>(makeEncoderFrame());
+	auto layout = std::make_shared<JpegHeaderLayout>();
+	benchmarks.push_back({ "scanJpegHeader", [frame, layout] {
+		layout->reset();
+		consume(scanJpegHeader(frame->data(), frame->size(), *layout).value);
+	} });
+	auto cache = std::make_shared<JpegSpliceCache>();
+	benchmarks.push_back({ "JpegSpliceCache/hit", [frame, cache] {
+		consume(cache->lookup(frame->data(), frame->size()).value->insertOffset);
+	} });
+
+	// Failure path over non-JPEG data, throwing versus status codes
+	auto garbage = std::make_shared<std::vector<uint8_t>>(256, 0x5A);
+	benchmarks.push_back({ "findFFDBMarker/fail", [garbage] {
+		try {
+			consume(findFFDBMarker(garbage->data(), garbage->size()));
+		}
+		catch (const std::exception&) {
+			consume(1);
+		}
+	} });
+	benchmarks.push_back({ "tryFindFFDBMarker/fail", [garbage] {
+		consume(static_cast<uint64_t>(tryFindFFDBMarker(garbage->data(), garbage->size()).error));
+	} });
+
+	if (!options.jpegFile.empty()) {
+		auto blob = std::make_shared<std::vector<uint8_t>>(builder->buildExifBlob());
+		std::string input = options.jpegFile;
+		std::string output = (std::filesystem::temp_directory_path() / "microexif_bench.jpg").string();
+		benchmarks.push_back({ "writeNewJpegWithExif", [blob, input, output] {
+			writeNewJpegWithExif(input, output, blob->data(), blob->size());
+		} });
+	}
+
+	return benchmarks;
+}
+
+void printCounter(std::ostream& out, const BenchmarkResult& result, PerfCounterId id) {
+	char text[32];
+	if (result.counters.valid[id]) {
+		snprintf(text, sizeof(text), "%14.2f", static_cast<double>(result.counters.value[id]) / result.iterations);
+	}
+	else {
+		snprintf(text, sizeof(text), "%14s", "n/a");
+	}
+	out << text;
+}
+
+// Command line values must parse completely, "10x" or "" are rejected rather than truncated
+bool parseBenchmarkNumber(const char* text, double& value) {
+	char* end = nullptr;
+	errno = 0;
+	double parsed = std::strtod(text, &end);
+	if (end == text || *end != '\0' || errno != 0 || !std::isfinite(parsed)) {
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+bool parseBenchmarkCount(const char* text, int& value) {
+	char* end = nullptr;
+	errno = 0;
+	long parsed = std::strtol(text, &end, 10);
+	if (end == text || *end != '\0' || errno != 0 || parsed < 1 || parsed > INT_MAX) {
+		return false;
+	}
+	value = static_cast<int>(parsed);
+	return true;
+}
+
+} // namespace
+
+std::vector<BenchmarkResult> runBenchmarks(const BenchmarkOptions& options) {
+	std::unique_ptr<PerfCounters> counters;
+	if (options.perf) {
+		counters = std::make_unique<PerfCounters>();
+		if (!counters->available()) {
+			std::cerr << "Hardware counters are not available (perf_event_open failed), reporting timings only." << std::endl;
+			counters.reset();
+		}
+	}
+
+	std::vector<BenchmarkResult> results;
+	for (const auto& benchmark : makeBenchmarks(options)) {
+		if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) {
+			continue;
+		}
+		results.push_back(runBenchmark(benchmark, options, counters.get()));
+	}
+	return results;
+}
+
+void printBenchmarkResults(const std::vector<BenchmarkResult>& results, bool perf, std::ostream& out) {
+	char line[128];
+	snprintf(line, sizeof(line), "%-24s %12s %12s %25s", "benchmark", "iterations", "ns/op", "95% CI");
+	out << line;
+	if (perf) {
+		for (int i = 0; i < PerfCounterCount; ++i) {
+			snprintf(line, sizeof(line), "%14s", PerfCounters::name(static_cast<PerfCounterId>(i)));
+			out << line;
+		}
+		snprintf(line, sizeof(line), "%8s", "IPC");
+		out << line;
+	}
+	out << "\n";
+
+	for (const auto& result : results) {
+		char interval[64];
+		snprintf(interval, sizeof(interval), "[%.1f, %.1f]", result.ciLow, result.ciHigh);
+		snprintf(line, sizeof(line), "%-24s %12llu %12.1f %25s", result.name.c_str(), static_cast<unsigned long long>(result.iterations), result.nsPerOp, interval);
+		out << line;
+		if (perf) {
+			for (int i = 0; i < PerfCounterCount; ++i) {
+				printCounter(out, result, static_cast<PerfCounterId>(i));
+			}
+			const PerfSample& c = result.counters;
+			if (c.valid[PerfCycles] && c.valid[PerfInstructions] && c.value[PerfCycles] != 0) {
+				snprintf(line, sizeof(line), "%8.2f", static_cast<double>(c.value[PerfInstructions]) / c.value[PerfCycles]);
+			}
+			else {
+				snprintf(line, sizeof(line), "%8s", "n/a");
+			}
+			out << line;
+		}
+		out << "\n";
+	}
+}
+
+void saveBenchmarkBaseline(const std::string& filename, const std::vector<BenchmarkResult>& results) {
+	std::ofstream file(filename);
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to create baseline file.");
+	}
+	file << "# MicroEXIF benchmark baseline: name median_ns ci_low_ns ci_high_ns repetitions\n";
+	file.precision(17);
+	for (const auto& result : results) {
+		file << result.name << ' ' << result.nsPerOp << ' ' << result.ciLow << ' ' << result.ciHigh << ' ' << result.samples.size() << '\n';
+	}
+	if (!file) {
+		throw std::runtime_error("Error writing baseline file.");
+	}
+}
+
+std::vector<BenchmarkResult> loadBenchmarkBaseline(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to open baseline file.");
+	}
+	std::vector<BenchmarkResult> baseline;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream fields(line);
+		BenchmarkResult result;
+		size_t repetitions = 0;
+		if (!(fields >> result.name >> result.nsPerOp >> result.ciLow >> result.ciHigh >> repetitions)) {
+			throw std::runtime_error("Malformed baseline file.");
+		}
+		result.samples.assign(repetitions, result.nsPerOp);
+		baseline.push_back(std::move(result));
+	}
+	return baseline;
+}
+
+std::vector<BenchmarkComparison> compareBenchmarks(const std::vector<BenchmarkResult>& baseline,
+	const std::vector<BenchmarkResult>& results, double thresholdPercent) {
+	std::vector<BenchmarkComparison> comparison;
+	for (const auto& result : results) {
+		BenchmarkComparison entry;
+		entry.name = result.name;
+		entry.currentNs = result.nsPerOp;
+		entry.verdict = BenchmarkVerdict::Missing;
+
+		auto base = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& b) { return b.name == result.name; });
+		if (base != baseline.end() && base->nsPerOp > 0) {
+			entry.baselineNs = base->nsPerOp;
+			entry.changePercent = (result.nsPerOp - base->nsPerOp) / base->nsPerOp * 100.0;
+			entry.verdict = BenchmarkVerdict::Unchanged;
+			// Significant only if the confidence intervals are disjoint
+			if (result.ciLow > base->ciHigh && entry.changePercent > thresholdPercent) {
+				entry.verdict = BenchmarkVerdict::Regressed;
+			}
+			else if (result.ciHigh < base->ciLow && entry.changePercent < -thresholdPercent) {
+				entry.verdict = BenchmarkVerdict::Improved;
+			}
+		}
+		comparison.push_back(entry);
+	}
+	return comparison;
+}
+
+void printBenchmarkComparison(const std::vector<BenchmarkComparison>& comparison, std::ostream& out) {
+	static const char* verdicts[] = { "unchanged", "IMPROVED", "REGRESSED", "new" };
+	char line[160];
+	snprintf(line, sizeof(line), "%-24s %14s %14s %9s  %s\n", "benchmark", "baseline ns", "current ns", "change", "verdict");
+	out << line;
+	for (const auto& entry : comparison) {
+		snprintf(line, sizeof(line), "%-24s %14.1f %14.1f %+8.1f%%  %s\n", entry.name.c_str(), entry.baselineNs, entry.currentNs,
+			entry.changePercent, verdicts[static_cast<int>(entry.verdict)]);
+		out << line;
+	}
+}
+
+int benchmarkMain(int argc, char* argv[]) {
+	BenchmarkOptions options;
+	std::string saveFile;
+	std::string compareFile;
+	double thresholdPercent = 5.0;
+	bool valid = true;
+	for (int i = 0; i < argc && valid; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--perf") {
+			options.perf = true;
+		}
+		else if (arg == "--time" && i + 1 < argc) {
+			valid = parseBenchmarkNumber(argv[++i], options.minTimeMs) && options.minTimeMs > 0;
+		}
+		else if (arg == "--filter" && i + 1 < argc) {
+			options.filter = argv[++i];
+		}
+		else if (arg == "--repeat" && i + 1 < argc) {
+			valid = parseBenchmarkCount(argv[++i], options.repetitions);
+		}
+		else if (arg == "--save" && i + 1 < argc) {
+			saveFile = argv[++i];
+		}
+		else if (arg == "--compare" && i + 1 < argc) {
+			compareFile = argv[++i];
+		}
+		else if (arg == "--threshold" && i + 1 < argc) {
+			valid = parseBenchmarkNumber(argv[++i], thresholdPercent) && thresholdPercent >= 0;
+		}
+		else if (arg.rfind("--", 0) != 0) {
+			options.jpegFile = arg;
+		}
+		else {
+			valid = false;
+		}
+	}
+	if (!valid) {
+		std::cerr << "Usage: --bench [--perf] [--time <ms>] [--filter <name>] [--repeat <n>]" << std::endl;
+		std::cerr << "               [--save <baseline>] [--compare <baseline> [--threshold <percent>]] [JPEG file]" << std::endl;
+		return 1;
+	}
+
+	// Baselines need a few repetitions for a meaningful confidence interval
+	if ((!saveFile.empty() || !compareFile.empty()) && options.repetitions == 1) {
+		options.repetitions = 10;
+	}
+
+	try {
+		// Load first, so that a bad baseline path fails before the long run
+		std::vector<BenchmarkResult> baseline;
+		if (!compareFile.empty()) {
+			baseline = loadBenchmarkBaseline(compareFile);
+		}
+
+		auto results = runBenchmarks(options);
+		printBenchmarkResults(results, options.perf, std::cout);
+
+		if (!saveFile.empty()) {
+			saveBenchmarkBaseline(saveFile, results);
+			std::cout << "Baseline saved: " << saveFile << std::endl;
+		}
+		if (!compareFile.empty()) {
+			auto comparison = compareBenchmarks(baseline, results, thresholdPercent);
+			std::cout << std::endl;
+			printBenchmarkComparison(comparison, std::cout);
+			for (const auto& entry : comparison) {
+				if (entry.verdict == BenchmarkVerdict::Regressed) {
+					std::cerr << "Performance regression above " << thresholdPercent << "% detected." << std::endl;
+					return 2;
+				}
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PerfCounters.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Benchmark harness:
+//
+// Micro-benchmarks for the builder and the injector, started with
+// "MicroExif --bench [options]". Each benchmark is calibrated to run for
+// roughly minTimeMs and reports nanoseconds per operation. With --perf the
+// harness also reports hardware counters per operation (see PerfCounters.h);
+// counters that cannot be opened are shown as n/a.
+//
+// With --repeat N every benchmark is measured N times and reported as the
+// median with a distribution-free 95% confidence interval. The results can be
+// saved as a baseline (--save) and later compared against it (--compare): a
+// change counts as significant only if the confidence intervals do not overlap,
+// and a significant slowdown above --threshold percent fails the run.
+//
+struct BenchmarkOptions {
+    bool perf = false;          // Read hardware counters around each benchmark
+    double minTimeMs = 200.0;   // Target duration of a measured run
+    std::string jpegFile;       // Optional input for the file injection benchmark
+    std::string filter;         // Only run benchmarks whose name contains this
+    int repetitions = 1;        // Measured runs per benchmark
+};
+
+struct BenchmarkResult {
+    std::string name;
+    uint64_t iterations = 0;    // Total over all repetitions
+    double nsPerOp = 0.0;       // Median over the repetitions
+    double ciLow = 0.0;         // 95% confidence interval of the median
+    double ciHigh = 0.0;
+    std::vector<double> samples;// ns/op of every repetition
+    PerfSample counters;        // Totals over all iterations
+};
+
+enum class BenchmarkVerdict {
+    Unchanged,
+    Improved,
+    Regressed,
+    Missing             // Benchmark is not in the baseline
+};
+
+struct BenchmarkComparison {
+    std::string name;
+    double baselineNs = 0.0;
+    double currentNs = 0.0;
+    double changePercent = 0.0;
+    BenchmarkVerdict verdict = BenchmarkVerdict::Unchanged;
+};
+
+std::vector<BenchmarkResult> runBenchmarks(const BenchmarkOptions& options);
+void printBenchmarkResults(const std::vector<BenchmarkResult>& results, bool perf, std::ostream& out);
+
+// Baseline files are plain text, one benchmark per line:
+// <name> <median ns/op> <ci low> <ci high> <repetitions>
+void saveBenchmarkBaseline(const std::string& filename, const std::vector<BenchmarkResult>& results);
+std::vector<BenchmarkResult> loadBenchmarkBaseline(const std::string& filename);
+
+// Compares results against a baseline, thresholdPercent is the minimal
+// relative change of the median that is reported as improved or regressed.
+std::vector<BenchmarkComparison> compareBenchmarks(const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& results, double thresholdPercent);
+void printBenchmarkComparison(const std::vector<BenchmarkComparison>& comparison, std::ostream& out);
+
+// Entry point for "--bench", argv[0] is the first option after "--bench"
+int benchmarkMain(int argc, char* argv[]);
@@ -0,0 +1,323 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "DurableWriter.h"
+#include "MicroExifProbes.h"
+
+namespace {
+
+std::atomic<uint64_t> temporaryCounter{ 0 };
+
+std::string parentDirectory(const std::string& path) {
+	std::string directory = std::filesystem::path(path).parent_path().string();
+	return directory.empty() ? "." : directory;
+}
+
+// Hidden name next to path for files that are not published yet
+std::string temporaryName(const std::string& path) {
+	std::filesystem::path target(path);
+	std::string name = "." + target.filename().string() + "." + std::to_string(temporaryCounter.fetch_add(1)) + ".tmp";
+	return (target.parent_path() / name).string();
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+	while (size > 0) {
+#ifdef _WIN32
+		int n = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30)));
+#else
+		ssize_t n = ::write(fd, data, size);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+#endif
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+void closeFile(int fd) {
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+}
+
+} // namespace
+
+DurableWriter::DurableWriter(const DurableOptions& durableOptions)
+	: options(durableOptions) {
+	options.maxPending = std::max<size_t>(1, options.maxPending);
+	committer = std::thread(&DurableWriter::commitLoop, this);
+}
+
+DurableWriter::~DurableWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	committer.join();
+	commit();
+}
+
+void DurableWriter::commitLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		wake.wait_for(lock, std::chrono::milliseconds(options.commitWindowMs));
+		if (!pending.empty() && !stopping) {
+			lock.unlock();
+			commit();
+			lock.lock();
+		}
+	}
+}
+
+ExifResult<size_t> DurableWriter::write(const std::string& path, const DurablePiece* pieces, size_t count) {
+	Pending file;
+	file.path = path;
+	file.device = 0;
+
+#ifdef _WIN32
+	file.temporary = temporaryName(path);
+	file.fd = _open(file.temporary.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	file.fd = -1;
+#ifdef O_TMPFILE
+	file.fd = open(parentDirectory(path).c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+#endif
+	if (file.fd < 0) {
+		// No O_TMPFILE support on this file system
+		file.temporary = temporaryName(path);
+		file.fd = open(file.temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	}
+#endif
+	if (file.fd < 0) {
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
+	}
+
+	size_t total = 0;
+	bool written = true;
+	for (size_t i = 0; i < count && written; ++i) {
+		written = writeAll(file.fd, pieces[i].data, pieces[i].size);
+		total += pieces[i].size;
+	}
+#ifndef _WIN32
+	struct stat info;
+	if (written && fstat(file.fd, &info) == 0) {
+		file.device = static_cast<uint64_t>(info.st_dev);
+	}
+#endif
+	if (!written) {
+		closeFile(file.fd);
+		if (!file.temporary.empty()) {
+			std::error_code error;
+			std::filesystem::remove(file.temporary, error);
+		}
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+
+	bool full = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(std::move(file));
+		full = pending.size() >= options.maxPending;
+	}
+	if (full) {
+		commit();
+	}
+	return ExifResult<size_t>::success(total);
+}
+
+bool DurableWriter::commit() {
+	std::lock_guard<std::mutex> commitLock(commitMutex);
+	std::vector<Pending> files;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		files.swap(pending);
+	}
+	if (files.empty()) {
+		return true;
+	}
+
+	size_t syncs = 0;
+	std::vector<bool> ok(files.size(), true);
+
+#ifdef _WIN32
+	for (size_t i = 0; i < files.size(); ++i) {
+		ok[i] = _commit(files[i].fd) == 0;
+		++syncs;
+		closeFile(files[i].fd);
+		ok[i] = ok[i] && MoveFileExA(files[i].temporary.c_str(), files[i].path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+#else
+	// One syncfs per file system covers the data of all files on it. A failed
+	// sync fails every file it covers, so no name points at lost data.
+	auto syncData = [&](bool metadata) {
+#ifdef __linux__
+		if (options.useSyncfs) {
+			std::vector<uint64_t> synced;
+			for (const auto& file : files) {
+				if (std::find(synced.begin(), synced.end(), file.device) != synced.end()) {
+					continue;
+				}
+				synced.push_back(file.device);
+				bool success = syncfs(file.fd) == 0;
+				++syncs;
+				for (size_t i = 0; i < files.size() && !success; ++i) {
+					ok[i] = ok[i] && files[i].device != file.device;
+				}
+			}
+			return;
+		}
+#endif
+		if (!metadata) {
+			for (size_t i = 0; i < files.size(); ++i) {
+				ok[i] = fdatasync(files[i].fd) == 0;
+				++syncs;
+			}
+			return;
+		}
+		std::vector<std::string> directories;
+		for (const auto& file : files) {
+			std::string directory = parentDirectory(file.path);
+			if (std::find(directories.begin(), directories.end(), directory) != directories.end()) {
+				continue;
+			}
+			directories.push_back(directory);
+			int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			bool success = fd >= 0 && fsync(fd) == 0;
+			if (fd >= 0) {
+				close(fd);
+				++syncs;
+			}
+			for (size_t i = 0; i < files.size() && !success; ++i) {
+				ok[i] = ok[i] && parentDirectory(files[i].path) != directory;
+			}
+		}
+	};
+
+	syncData(false);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		Pending& file = files[i];
+		if (!ok[i]) {
+			continue;
+		}
+		if (!file.temporary.empty()) {
+			ok[i] = rename(file.temporary.c_str(), file.path.c_str()) == 0;
+			continue;
+		}
+		// Anonymous file: link it in, over an existing file via a temporary name
+		std::string procPath = "/proc/self/fd/" + std::to_string(file.fd);
+		if (linkat(AT_FDCWD, procPath.c_str(), AT_FDCWD, file.path.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+			continue;
+		}
+		if (errno != EEXIST) {
+			ok[i] = false;
+			continue;
+		}
+		std::string temporary = temporaryName(file.path);
+		ok[i] = linkat(AT_FDCWD, procPath.c_str(), AT_FDCWD, temporary.c_str(), AT_SYMLINK_FOLLOW) == 0
+			&& rename(temporary.c_str(), file.path.c_str()) == 0;
+		if (!ok[i]) {
+			unlink(temporary.c_str());
+		}
+	}
+
+	syncData(true);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		closeFile(files[i].fd);
+		if (!ok[i] && !files[i].temporary.empty()) {
+			unlink(files[i].temporary.c_str());
+		}
+	}
+#endif
+
+	size_t failed = static_cast<size_t>(std::count(ok.begin(), ok.end(), false));
+	std::lock_guard<std::mutex> lock(mutex);
+	counters.files += files.size() - failed;
+	counters.failed += failed;
+	counters.syncs += syncs;
+	++counters.commits;
+	return failed == 0;
+}
+
+DurableWriter::Stats DurableWriter::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+ExifResult<size_t> writeDurableJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize,
+	DurableWriter& writer) {
+	MicroExifWriteProbes probes;
+	size_t fileSize = 0;
+	auto jpegData = tryReadJpegFile(originalFile, fileSize);
+	if (!jpegData) {
+		return ExifResult<size_t>::failure(jpegData.error, jpegData.offset);
+	}
+	std::unique_ptr<uint8_t[]> data(jpegData.value);
+
+	auto marker = tryFindFFDBMarker(data.get(), fileSize);
+	if (!marker) {
+		return marker;
+	}
+	size_t pos = marker.value;
+	const DurablePiece pieces[3] = {
+		{ data.get(), pos },
+		{ exifBlob, exifSize },
+		{ data.get() + pos, fileSize - pos }
+	};
+	probes.writeStart(fileSize, exifSize);
+	auto written = writer.write(newFile, pieces, 3);
+	if (written) {
+		// Published by the next commit; file__done covers the write only
+		probes.done(newFile.c_str(), written.value);
+	}
+	return written;
+}
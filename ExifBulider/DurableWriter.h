@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// DurableWriter:
+//
+// Crash-safe output with group commit. write() puts the data into an
+// anonymous O_TMPFILE in the target directory (a hidden temporary file
+// where O_TMPFILE is not supported) and returns; the file is not visible
+// under its name yet. A commit then, for all pending files at once:
+//
+//   1. makes the data durable: one syncfs() per file system, or fdatasync()
+//      per file with useSyncfs off,
+//   2. publishes each file under its name with linkat(), or link to a
+//      temporary name and rename() over an existing file,
+//   3. makes the new directory entries durable: syncfs() again, or fsync()
+//      per directory.
+//
+// After a crash a name therefore holds either the old or the complete new
+// file. A file whose data sync fails is not published; one whose directory
+// sync fails is published but counted as failed. Commits run every commitWindowMs on a background thread, and
+// immediately when maxPending files are waiting (each holds a descriptor).
+// On Windows the data is flushed with _commit() and published with
+// MoveFileEx(MOVEFILE_WRITE_THROUGH).
+//
+struct DurableOptions {
+    unsigned commitWindowMs = 50;
+    size_t maxPending = 256;
+    bool useSyncfs = true;                  // Linux: one syncfs per file system instead of fdatasync per file
+};
+
+struct DurablePiece {
+    const uint8_t* data;
+    size_t size;
+};
+
+class DurableWriter {
+public:
+    struct Stats {
+        size_t files = 0;                   // Published
+        size_t commits = 0;
+        size_t syncs = 0;                   // syncfs/fdatasync/fsync calls
+        size_t failed = 0;                  // Files that could not be published or made durable
+    };
+
+    explicit DurableWriter(const DurableOptions& options = DurableOptions());
+    ~DurableWriter();
+
+    DurableWriter(const DurableWriter&) = delete;
+    DurableWriter& operator=(const DurableWriter&) = delete;
+
+    // Thread-safe. The file appears at path after the next commit. The value
+    // of the result is the number of bytes written.
+    ExifResult<size_t> write(const std::string& path, const DurablePiece* pieces, size_t count);
+
+    // Commits the pending files now, returns false if any of them failed
+    bool commit();
+
+    Stats stats() const;
+
+private:
+    struct Pending {
+        int fd;
+        std::string path;
+        std::string temporary;              // Empty for O_TMPFILE
+        uint64_t device;
+    };
+
+    void commitLoop();
+
+    DurableOptions options;
+    mutable std::mutex mutex;
+    std::mutex commitMutex;                 // One commit at a time
+    std::condition_variable wake;
+    std::vector<Pending> pending;
+    Stats counters;
+    bool stopping = false;
+    std::thread committer;
+};
+
+// writeNewJpegWithExif() through a DurableWriter
+ExifResult<size_t> writeDurableJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize,
+    DurableWriter& writer);
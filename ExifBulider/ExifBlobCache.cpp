@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "ExifBlobCache.h"
+
+ExifBlobCache::ExifBlobCache(size_t byteBudget, size_t shardCount) {
+	shardCount = std::max<size_t>(1, shardCount);
+	shardBudget = std::max<size_t>(1, byteBudget / shardCount);
+	for (size_t i = 0; i < shardCount; ++i) {
+		shards.push_back(std::make_unique<Shard>());
+	}
+}
+
+void ExifBlobCache::canonicalKey(const ExifBuilder& tags, std::vector<uint8_t>& key) {
+	const auto& list = tags.getTags();
+	// Tag sets are small, an index sort is cheaper than copying the tags
+	uint16_t order[256];
+	std::vector<uint16_t> largeOrder;
+	uint16_t* sorted = order;
+	if (list.size() > 256) {
+		largeOrder.resize(list.size());
+		sorted = largeOrder.data();
+	}
+	for (size_t i = 0; i < list.size(); ++i) {
+		sorted[i] = static_cast<uint16_t>(i);
+	}
+	auto byTag = [&](uint16_t a, uint16_t b) { return list[a].tag < list[b].tag; };
+	if (!std::is_sorted(sorted, sorted + list.size(), byTag)) {
+		std::sort(sorted, sorted + list.size(), byTag);
+	}
+
+	key.clear();
+	for (size_t i = 0; i < list.size(); ++i) {
+		const ExifTag& tag = list[sorted[i]];
+		uint8_t header[12];
+		ExifBuilder::putUInt16(header, tag.tag, false);
+		ExifBuilder::putUInt16(header + 2, tag.type, false);
+		ExifBuilder::putUInt32(header + 4, tag.count, false);
+		ExifBuilder::putUInt32(header + 8, static_cast<uint32_t>(tag.value.size()), false);
+		key.insert(key.end(), header, header + sizeof(header));
+		key.insert(key.end(), tag.value.begin(), tag.value.end());
+	}
+}
+
+ExifBlobCache::Blob ExifBlobCache::get(const ExifBuilder& tags) {
+	thread_local std::vector<uint8_t> key;
+	canonicalKey(tags, key);
+	uint64_t hash = exifHash64Words(key.data(), key.size());
+	Shard& shard = *shards[(hash >> 32) % shards.size()];
+
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto found = shard.index.find(hash);
+		if (found != shard.index.end() && found->second->key == key) {
+			shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+			hits.fetch_add(1, std::memory_order_relaxed);
+			return found->second->blob;
+		}
+	}
+	misses.fetch_add(1, std::memory_order_relaxed);
+
+	// Build outside the lock; if two workers miss at once, both build and the
+	// second insert finds the first one
+	ExifBuilder sorted;
+	std::vector<ExifTag> list = tags.getTags();
+	std::stable_sort(list.begin(), list.end(), [](const ExifTag& a, const ExifTag& b) { return a.tag < b.tag; });
+	for (auto& tag : list) {
+		sorted.addTag(std::move(tag));
+	}
+	auto blob = std::make_shared<std::vector<uint8_t>>(sorted.exifBlobSize());
+	if (sorted.buildExifBlobInto(blob->data(), blob->size()) == 0) {
+		return nullptr;
+	}
+
+	size_t entryBytes = key.size() + blob->size();
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto found = shard.index.find(hash);
+	if (found != shard.index.end()) {
+		if (found->second->key == key) {
+			shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+			return found->second->blob;
+		}
+		// Collision: the newer tag set takes the slot
+		shard.bytes -= found->second->key.size() + found->second->blob->size();
+		shard.lru.erase(found->second);
+		shard.index.erase(found);
+	}
+	if (entryBytes > shardBudget) {
+		return blob;
+	}
+	while (shard.bytes + entryBytes > shardBudget && !shard.lru.empty()) {
+		const Entry& oldest = shard.lru.back();
+		shard.bytes -= oldest.key.size() + oldest.blob->size();
+		shard.index.erase(oldest.hash);
+		shard.lru.pop_back();
+		evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+	shard.lru.push_front(Entry{ hash, key, blob });
+	shard.index[hash] = shard.lru.begin();
+	shard.bytes += entryBytes;
+	return blob;
+}
+
+ExifBlobCache::Stats ExifBlobCache::stats() const {
+	Stats result;
+	result.hits = hits.load(std::memory_order_relaxed);
+	result.misses = misses.load(std::memory_order_relaxed);
+	result.evictions = evictions.load(std::memory_order_relaxed);
+	for (const auto& shard : shards) {
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		result.entries += shard->lru.size();
+		result.bytes += shard->bytes;
+	}
+	return result;
+}
+
+void ExifBlobCache::clear() {
+	for (auto& shard : shards) {
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		shard->lru.clear();
+		shard->index.clear();
+		shard->bytes = 0;
+	}
+}
+
+ExifBlobCache& exifBlobCache() {
+	static ExifBlobCache cache;
+	return cache;
+}
@@ -0,0 +1,98 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// ExifBlobCache:
+//
+// Concurrent cache from a tag set to its serialized APP1 blob, so batch
+// workers build each distinct blob once per run and then share the bytes.
+//
+// The key is a canonical encoding of the tags (sorted by tag ID, with type,
+// count and value), so the order in which the tags were added does not
+// matter; blobs are built from the sorted tags as well. Lookups hash the
+// key into one of several shards, each with its own mutex, LRU list and
+// share of the byte budget. A hit compares the full key, so hash collisions
+// cannot return a wrong blob. Blobs are immutable and reference counted, an
+// evicted blob stays valid for the workers that still hold it.
+//
+class ExifBlobCache {
+public:
+    using Blob = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;               // Keys and blobs
+    };
+
+    explicit ExifBlobCache(size_t byteBudget = 16 * 1024 * 1024, size_t shardCount = 16);
+
+    ExifBlobCache(const ExifBlobCache&) = delete;
+    ExifBlobCache& operator=(const ExifBlobCache&) = delete;
+
+    // Blob for the tag set, built on a miss. nullptr if the tags do not fit
+    // into an APP1 segment.
+    Blob get(const ExifBuilder& tags);
+
+    Stats stats() const;
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::vector<uint8_t> key;
+        Blob blob;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;       // Most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    static void canonicalKey(const ExifBuilder& tags, std::vector<uint8_t>& key);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardBudget;
+    std::atomic<size_t> hits{ 0 };
+    std::atomic<size_t> misses{ 0 };
+    std::atomic<size_t> evictions{ 0 };
+};
+
+// Process-wide instance with the default budget
+ExifBlobCache& exifBlobCache();
@@ -0,0 +1,556 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+#include "ExifDelta.h"
+#include "JpegHeader.h"
+
+#ifdef _WIN32
+#define microexif_fseek _fseeki64
+#define microexif_ftell _ftelli64
+#else
+#define microexif_fseek fseeko
+#define microexif_ftell ftello
+#endif
+
+namespace {
+
+const char recordMagic[4] = { 'M', 'X', 'D', '1' };
+constexpr size_t recordHeaderSize = 8;
+constexpr size_t tailSize = 4096;
+
+struct ExifEntry {
+	uint16_t tag;
+	uint16_t type;
+	uint32_t count;
+	size_t entryOffset;         // File offsets
+	size_t valueOffset;
+	size_t valueSize;
+	bool inField;
+};
+
+struct ExifSegment {
+	bool present = false;
+	size_t offset = 0;          // Offset of the APP1 marker
+	size_t length = 0;          // Including the marker
+	size_t tiff = 0;            // Offset of the TIFF header
+	bool bigendian = true;
+	uint32_t ifd0 = 0;          // Relative to the TIFF header
+	size_t ifd0Entries = 0;     // The first entries are the ones of IFD0
+	std::vector<ExifEntry> entries;
+
+	const ExifEntry* find(uint16_t tag) const {
+		for (const auto& entry : entries) {
+			if (entry.tag == tag) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+};
+
+struct FileSnapshot {
+	std::vector<uint8_t> header;
+	JpegHeaderLayout layout;
+	ExifSegment exif;
+	uint64_t imageSize = 0;
+	uint64_t identity = 0;
+};
+
+uint16_t getUInt16(const uint8_t* src, bool bigendian) {
+	return static_cast<uint16_t>(bigendian ? (src[0] << 8) | src[1] : (src[1] << 8) | src[0]);
+}
+
+uint32_t getUInt32(const uint8_t* src, bool bigendian) {
+	return bigendian
+		? (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 8) | src[3]
+		: (static_cast<uint32_t>(src[3]) << 24) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[1]) << 8) | src[0];
+}
+
+uint64_t getUInt64(const uint8_t* src) {
+	return static_cast<uint64_t>(getUInt32(src, false)) | (static_cast<uint64_t>(getUInt32(src + 4, false)) << 32);
+}
+
+void appendUInt16(std::vector<uint8_t>& output, uint16_t value) {
+	uint8_t bytes[2];
+	ExifBuilder::putUInt16(bytes, value, false);
+	output.insert(output.end(), bytes, bytes + 2);
+}
+
+void appendUInt32(std::vector<uint8_t>& output, uint32_t value) {
+	uint8_t bytes[4];
+	ExifBuilder::putUInt32(bytes, value, false);
+	output.insert(output.end(), bytes, bytes + 4);
+}
+
+void appendUInt64(std::vector<uint8_t>& output, uint64_t value) {
+	appendUInt32(output, static_cast<uint32_t>(value));
+	appendUInt32(output, static_cast<uint32_t>(value >> 32));
+}
+
+ExifError parseIfd(const uint8_t* data, ExifSegment& exif, uint32_t ifdOffset) {
+	size_t tiffSize = exif.offset + exif.length - exif.tiff;
+	const uint8_t* tiff = data + exif.tiff;
+	if (ifdOffset + 2ull > tiffSize) {
+		return ExifError::Malformed;
+	}
+	size_t count = getUInt16(tiff + ifdOffset, exif.bigendian);
+	if (ifdOffset + 2ull + count * 12 + 4 > tiffSize) {
+		return ExifError::Malformed;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		const uint8_t* raw = tiff + ifdOffset + 2 + i * 12;
+		ExifEntry entry;
+		entry.tag = getUInt16(raw, exif.bigendian);
+		entry.type = getUInt16(raw + 2, exif.bigendian);
+		entry.count = getUInt32(raw + 4, exif.bigendian);
+		entry.entryOffset = exif.tiff + ifdOffset + 2 + i * 12;
+		uint64_t size = static_cast<uint64_t>(entry.count) * ExifBuilder::typeSize(entry.type);
+		entry.inField = size <= 4;
+		if (entry.inField) {
+			entry.valueOffset = entry.entryOffset + 8;
+		}
+		else {
+			uint32_t valueOffset = getUInt32(raw + 8, exif.bigendian);
+			if (valueOffset + size > tiffSize) {
+				return ExifError::Malformed;
+			}
+			entry.valueOffset = exif.tiff + valueOffset;
+		}
+		entry.valueSize = static_cast<size_t>(size);
+		exif.entries.push_back(entry);
+	}
+	return ExifError::None;
+}
+
+ExifError parseExifSegment(const uint8_t* data, const JpegHeaderLayout& layout, ExifSegment& exif) {
+	for (const auto& segment : layout.segments) {
+		if (!isJpegAppSegment(data, segment, 0xE1, "Exif\0", 6)) {
+			continue;
+		}
+		exif.present = true;
+		exif.offset = segment.offset;
+		exif.length = segment.length;
+		exif.tiff = segment.offset + ExifBuilder::app1HeaderSize;
+		if (segment.length < ExifBuilder::app1HeaderSize + 8) {
+			return ExifError::Malformed;
+		}
+		const uint8_t* tiff = data + exif.tiff;
+		if (tiff[0] == 'M' && tiff[1] == 'M') {
+			exif.bigendian = true;
+		}
+		else if (tiff[0] == 'I' && tiff[1] == 'I') {
+			exif.bigendian = false;
+		}
+		else {
+			return ExifError::Malformed;
+		}
+		if (getUInt16(tiff + 2, exif.bigendian) != 0x002A) {
+			return ExifError::Malformed;
+		}
+		exif.ifd0 = getUInt32(tiff + 4, exif.bigendian);
+		ExifError error = parseIfd(data, exif, exif.ifd0);
+		exif.ifd0Entries = exif.entries.size();
+
+		// Exif sub-IFD
+		const ExifEntry* pointer = exif.find(0x8769);
+		if (error == ExifError::None && pointer && pointer->type == 0x0004 && pointer->count == 1) {
+			error = parseIfd(data, exif, getUInt32(data + pointer->valueOffset, exif.bigendian));
+		}
+		return error;
+	}
+	return ExifError::None;
+}
+
+uint64_t valueHash(uint16_t type, uint32_t count, const uint8_t* value, size_t size) {
+	uint8_t meta[6];
+	ExifBuilder::putUInt16(meta, type, false);
+	ExifBuilder::putUInt32(meta + 2, count, false);
+	return exifHash64(value, size, exifHash64(meta, sizeof(meta)));
+}
+
+uint64_t entryHash(const uint8_t* data, const ExifEntry* entry) {
+	return entry ? valueHash(entry->type, entry->count, data + entry->valueOffset, entry->valueSize) : 0;
+}
+
+bool entryEquals(const uint8_t* data, const ExifEntry* entry, const ExifTagChange& change) {
+	return entry && entry->type == change.type && entry->count == change.count && entry->valueSize == change.value.size()
+		&& std::memcmp(data + entry->valueOffset, change.value.data(), change.value.size()) == 0;
+}
+
+// Values of up to 4 bytes always go into the entry itself, larger ones may
+// reuse an old out-of-line slot of the same type that is large enough
+bool fitsOldSlot(const ExifEntry* entry, const ExifTagChange& change) {
+	return entry && entry->type == change.type
+		&& (change.value.size() <= 4 || (!entry->inField && change.value.size() <= entry->valueSize));
+}
+
+// Reads the header and the tail of a file and computes its identity
+ExifError loadSnapshot(FILE* file, FileSnapshot& snapshot) {
+	if (microexif_fseek(file, 0, SEEK_END) != 0) {
+		return ExifError::ReadFailed;
+	}
+	uint64_t fileSize = static_cast<uint64_t>(microexif_ftell(file));
+	rewind(file);
+
+	auto scanned = readJpegHeader(file, snapshot.header, snapshot.layout);
+	if (!scanned) {
+		return scanned.error;
+	}
+	ExifError error = parseExifSegment(snapshot.header.data(), snapshot.layout, snapshot.exif);
+	if (error != ExifError::None) {
+		return error;
+	}
+
+	size_t headerSize = snapshot.layout.headerSize;
+	size_t tail = static_cast<size_t>(std::min<uint64_t>(tailSize, fileSize - headerSize));
+	uint8_t tailData[tailSize];
+	if (microexif_fseek(file, static_cast<int64_t>(fileSize - tail), SEEK_SET) != 0 || fread(tailData, 1, tail, file) != tail) {
+		return ExifError::ReadFailed;
+	}
+
+	const ExifSegment& exif = snapshot.exif;
+	const uint8_t* header = snapshot.header.data();
+	snapshot.imageSize = fileSize - (exif.present ? exif.length : 0);
+	uint64_t hash = exif.present
+		? exifHash64(header + exif.offset + exif.length, headerSize - exif.offset - exif.length, exifHash64(header, exif.offset))
+		: exifHash64(header, headerSize);
+	uint8_t size[8];
+	ExifBuilder::putUInt32(size, static_cast<uint32_t>(snapshot.imageSize), false);
+	ExifBuilder::putUInt32(size + 4, static_cast<uint32_t>(snapshot.imageSize >> 32), false);
+	snapshot.identity = exifHash64(size, 8, exifHash64(tailData, tail, hash));
+	return ExifError::None;
+}
+
+// Rewrites the file with the changes applied to a grown copy of its APP1
+// segment. Values that do not fit are appended to the segment and tags that
+// do not exist get a new IFD0 behind them, so existing offsets stay valid.
+ExifError rewriteWithChanges(const std::string& path, const FileSnapshot& snapshot, const ExifDeltaRecord& record, const std::vector<const ExifTagChange*>& pending) {
+	size_t fileSize = 0;
+	auto read = tryReadJpegFile(path, fileSize);
+	if (!read) {
+		return read.error;
+	}
+	std::unique_ptr<uint8_t[]> data(read.value);
+	if (fileSize < snapshot.layout.headerSize) {
+		return ExifError::Mismatch;
+	}
+
+	const ExifSegment& exif = snapshot.exif;
+	bool bigendian = record.bigendian;
+	std::vector<uint8_t> segment;
+	size_t position = 0;
+	size_t replaced = 0;
+	uint32_t ifd0 = 8;
+	if (exif.present) {
+		position = exif.offset;
+		replaced = exif.length;
+		ifd0 = exif.ifd0;
+		segment.assign(data.get() + exif.offset, data.get() + exif.offset + exif.length);
+	}
+	else {
+		// Empty EXIF segment behind SOI/APP0
+		position = snapshot.layout.insertOffset;
+		ExifBuilder empty;
+		segment = empty.buildExifBlob();
+		ExifBuilder::putUInt16(segment.data() + ExifBuilder::app1HeaderSize, bigendian ? 0x4D4D : 0x4949, true);
+		ExifBuilder::putUInt16(segment.data() + ExifBuilder::app1HeaderSize + 2, 0x002A, bigendian);
+		ExifBuilder::putUInt32(segment.data() + ExifBuilder::app1HeaderSize + 4, 8, bigendian);
+	}
+
+	uint8_t* tiff = segment.data() + ExifBuilder::app1HeaderSize;
+	auto appendValue = [&](const std::vector<uint8_t>& value) {
+		if (segment.size() % 2 != 0) {
+			segment.push_back(0);
+		}
+		uint32_t offset = static_cast<uint32_t>(segment.size() - ExifBuilder::app1HeaderSize);
+		segment.insert(segment.end(), value.begin(), value.end());
+		tiff = segment.data() + ExifBuilder::app1HeaderSize;
+		return offset;
+	};
+
+	std::vector<std::vector<uint8_t>> newEntries;
+	for (const ExifTagChange* change : pending) {
+		const ExifEntry* entry = exif.present ? exif.find(change->tag) : nullptr;
+		if (!entry) {
+			std::vector<uint8_t> raw(12, 0);
+			ExifBuilder::putUInt16(raw.data(), change->tag, bigendian);
+			ExifBuilder::putUInt16(raw.data() + 2, change->type, bigendian);
+			ExifBuilder::putUInt32(raw.data() + 4, change->count, bigendian);
+			if (change->value.size() <= 4) {
+				std::memcpy(raw.data() + 8, change->value.data(), change->value.size());
+			}
+			else {
+				ExifBuilder::putUInt32(raw.data() + 8, appendValue(change->value), bigendian);
+			}
+			newEntries.push_back(std::move(raw));
+			continue;
+		}
+
+		size_t entryOffset = entry->entryOffset - exif.offset;
+		if (change->value.size() <= 4) {
+			std::memset(segment.data() + entryOffset + 8, 0, 4);
+			std::memcpy(segment.data() + entryOffset + 8, change->value.data(), change->value.size());
+		}
+		else if (fitsOldSlot(entry, *change)) {
+			uint8_t* value = segment.data() + (entry->valueOffset - exif.offset);
+			std::memcpy(value, change->value.data(), change->value.size());
+			std::memset(value + change->value.size(), 0, entry->valueSize - change->value.size());
+		}
+		else {
+			uint32_t offset = appendValue(change->value);
+			ExifBuilder::putUInt32(segment.data() + entryOffset + 8, offset, bigendian);
+		}
+		ExifBuilder::putUInt16(segment.data() + entryOffset + 2, change->type, bigendian);
+		ExifBuilder::putUInt32(segment.data() + entryOffset + 4, change->count, bigendian);
+	}
+
+	if (!newEntries.empty()) {
+		// New IFD0: the old entries plus the new ones, sorted by tag
+		size_t oldCount = getUInt16(tiff + ifd0, bigendian);
+		for (size_t i = 0; i < oldCount; ++i) {
+			const uint8_t* raw = tiff + ifd0 + 2 + i * 12;
+			newEntries.emplace_back(raw, raw + 12);
+		}
+		uint32_t nextIfd = getUInt32(tiff + ifd0 + 2 + oldCount * 12, bigendian);
+		std::sort(newEntries.begin(), newEntries.end(), [&](const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+			return getUInt16(a.data(), bigendian) < getUInt16(b.data(), bigendian);
+		});
+
+		std::vector<uint8_t> ifd(2 + newEntries.size() * 12 + 4);
+		ExifBuilder::putUInt16(ifd.data(), static_cast<uint16_t>(newEntries.size()), bigendian);
+		for (size_t i = 0; i < newEntries.size(); ++i) {
+			std::memcpy(ifd.data() + 2 + i * 12, newEntries[i].data(), 12);
+		}
+		ExifBuilder::putUInt32(ifd.data() + ifd.size() - 4, nextIfd, bigendian);
+		uint32_t ifdOffset = appendValue(ifd);
+		ExifBuilder::putUInt32(tiff + 4, ifdOffset, bigendian);
+	}
+
+	if (segment.size() - 2 > 0xFFFF) {
+		return ExifError::TooLarge;
+	}
+	ExifBuilder::putUInt16(segment.data() + 2, static_cast<uint16_t>(segment.size() - 2), true);
+
+	// Write next to the replica and replace it
+	std::string temporary = path + ".delta.tmp";
+	FILE* output = fopen(temporary.c_str(), "wb");
+	if (!output) {
+		return ExifError::CreateFailed;
+	}
+	size_t rest = fileSize - position - replaced;
+	bool written = fwrite(data.get(), 1, position, output) == position
+		&& fwrite(segment.data(), 1, segment.size(), output) == segment.size()
+		&& fwrite(data.get() + position + replaced, 1, rest, output) == rest;
+	written = (fclose(output) == 0) && written;
+	std::error_code error;
+	if (written) {
+		std::filesystem::rename(temporary, path, error);
+	}
+	if (!written || error) {
+		std::filesystem::remove(temporary, error);
+		return ExifError::WriteFailed;
+	}
+	return ExifError::None;
+}
+
+} // namespace
+
+ExifResult<size_t> createExifDelta(const std::string& path, const ExifBuilder& edits, ExifDeltaRecord& record) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return ExifResult<size_t>::failure(ExifError::OpenFailed);
+	}
+	FileSnapshot snapshot;
+	ExifError error = loadSnapshot(file, snapshot);
+	fclose(file);
+	if (error != ExifError::None) {
+		return ExifResult<size_t>::failure(error);
+	}
+
+	const ExifSegment& exif = snapshot.exif;
+	record.path = path;
+	record.imageSize = snapshot.imageSize;
+	record.identity = snapshot.identity;
+	record.bigendian = exif.present ? exif.bigendian : true;
+	record.changes.clear();
+	for (const auto& tag : edits.getTags()) {
+		ExifTagChange change;
+		change.tag = tag.tag;
+		change.type = tag.type;
+		change.count = tag.count;
+		change.value.resize(tag.value.size());
+		ExifBuilder::writeTagValue(change.value.data(), tag, record.bigendian);
+
+		const ExifEntry* entry = exif.find(tag.tag);
+		if (entryEquals(snapshot.header.data(), entry, change)) {
+			continue;
+		}
+		change.oldValueHash = entryHash(snapshot.header.data(), entry);
+		record.changes.push_back(std::move(change));
+	}
+	return ExifResult<size_t>::success(record.changes.size());
+}
+
+void encodeExifDelta(const ExifDeltaRecord& record, std::vector<uint8_t>& output) {
+	size_t start = output.size();
+	output.insert(output.end(), recordMagic, recordMagic + 4);
+	appendUInt32(output, 0);       // Record size, patched below
+	appendUInt16(output, static_cast<uint16_t>(record.path.size()));
+	output.insert(output.end(), record.path.begin(), record.path.end());
+	appendUInt64(output, record.imageSize);
+	appendUInt64(output, record.identity);
+	output.push_back(record.bigendian ? 1 : 0);
+	appendUInt16(output, static_cast<uint16_t>(record.changes.size()));
+	for (const auto& change : record.changes) {
+		appendUInt16(output, change.tag);
+		appendUInt16(output, change.type);
+		appendUInt32(output, change.count);
+		appendUInt64(output, change.oldValueHash);
+		appendUInt32(output, static_cast<uint32_t>(change.value.size()));
+		output.insert(output.end(), change.value.begin(), change.value.end());
+	}
+	ExifBuilder::putUInt32(output.data() + start + 4, static_cast<uint32_t>(output.size() - start), false);
+}
+
+ExifResult<size_t> decodeExifDelta(const uint8_t* data, size_t size, ExifDeltaRecord& record) {
+	if (size < recordHeaderSize) {
+		return ExifResult<size_t>::failure(ExifError::Truncated, recordHeaderSize);
+	}
+	if (std::memcmp(data, recordMagic, 4) != 0) {
+		return ExifResult<size_t>::failure(ExifError::Malformed);
+	}
+	size_t recordSize = getUInt32(data + 4, false);
+	if (recordSize > size) {
+		return ExifResult<size_t>::failure(ExifError::Truncated, recordSize);
+	}
+
+	size_t pos = recordHeaderSize;
+	auto need = [&](size_t bytes) { return pos + bytes <= recordSize; };
+	if (!need(2)) {
+		return ExifResult<size_t>::failure(ExifError::Malformed, pos);
+	}
+	size_t pathSize = getUInt16(data + pos, false);
+	pos += 2;
+	if (!need(pathSize + 19)) {
+		return ExifResult<size_t>::failure(ExifError::Malformed, pos);
+	}
+	record.path.assign(reinterpret_cast<const char*>(data + pos), pathSize);
+	pos += pathSize;
+	record.imageSize = getUInt64(data + pos);
+	record.identity = getUInt64(data + pos + 8);
+	record.bigendian = data[pos + 16] != 0;
+	size_t changes = getUInt16(data + pos + 17, false);
+	pos += 19;
+
+	record.changes.resize(changes);
+	for (auto& change : record.changes) {
+		if (!need(20)) {
+			return ExifResult<size_t>::failure(ExifError::Malformed, pos);
+		}
+		change.tag = getUInt16(data + pos, false);
+		change.type = getUInt16(data + pos + 2, false);
+		change.count = getUInt32(data + pos + 4, false);
+		change.oldValueHash = getUInt64(data + pos + 8);
+		size_t valueSize = getUInt32(data + pos + 16, false);
+		pos += 20;
+		if (!need(valueSize) || valueSize != static_cast<uint64_t>(change.count) * ExifBuilder::typeSize(change.type)) {
+			return ExifResult<size_t>::failure(ExifError::Malformed, pos);
+		}
+		change.value.assign(data + pos, data + pos + valueSize);
+		pos += valueSize;
+	}
+	return ExifResult<size_t>::success(recordSize);
+}
+
+ExifResult<ExifDeltaOutcome> applyExifDelta(const ExifDeltaRecord& record, const std::string& replicaPath) {
+	using Result = ExifResult<ExifDeltaOutcome>;
+
+	FILE* file = fopen(replicaPath.c_str(), "r+b");
+	if (!file) {
+		return Result::failure(ExifError::OpenFailed);
+	}
+	FileSnapshot snapshot;
+	ExifError error = loadSnapshot(file, snapshot);
+	const ExifSegment& exif = snapshot.exif;
+	if (error == ExifError::None && (snapshot.imageSize != record.imageSize || snapshot.identity != record.identity
+		|| (exif.present && exif.bigendian != record.bigendian))) {
+		error = ExifError::Mismatch;
+	}
+
+	// Skip the changes that are already there, refuse conflicting ones
+	std::vector<const ExifTagChange*> pending;
+	bool inPlace = true;
+	const uint8_t* header = snapshot.header.data();
+	for (size_t i = 0; error == ExifError::None && i < record.changes.size(); ++i) {
+		const ExifTagChange& change = record.changes[i];
+		const ExifEntry* entry = exif.find(change.tag);
+		if (entryEquals(header, entry, change)) {
+			continue;
+		}
+		if (entryHash(header, entry) != change.oldValueHash) {
+			error = ExifError::Mismatch;
+			break;
+		}
+		pending.push_back(&change);
+		inPlace = inPlace && fitsOldSlot(entry, change);
+	}
+	if (error != ExifError::None) {
+		fclose(file);
+		return Result::failure(error);
+	}
+	if (pending.empty()) {
+		fclose(file);
+		return Result::success(ExifDeltaOutcome::AlreadyApplied);
+	}
+
+	if (!inPlace) {
+		fclose(file);
+		error = rewriteWithChanges(replicaPath, snapshot, record, pending);
+		return error == ExifError::None ? Result::success(ExifDeltaOutcome::Rewritten) : Result::failure(error);
+	}
+
+	// Every value fits into its old slot: write the count and the zero-padded
+	// value, small values into the entry even if they used to be out of line
+	bool written = true;
+	for (const ExifTagChange* change : pending) {
+		const ExifEntry* entry = exif.find(change->tag);
+		uint8_t count[4];
+		ExifBuilder::putUInt32(count, change->count, record.bigendian);
+		bool inField = change->value.size() <= 4;
+		std::vector<uint8_t> value(inField ? 4 : entry->valueSize, 0);
+		std::memcpy(value.data(), change->value.data(), change->value.size());
+		size_t valueOffset = inField ? entry->entryOffset + 8 : entry->valueOffset;
+		written = written
+			&& microexif_fseek(file, static_cast<int64_t>(entry->entryOffset + 4), SEEK_SET) == 0 && fwrite(count, 1, 4, file) == 4
+			&& microexif_fseek(file, static_cast<int64_t>(valueOffset), SEEK_SET) == 0 && fwrite(value.data(), 1, value.size(), file) == value.size();
+	}
+	written = (fclose(file) == 0) && written;
+	return written ? Result::success(ExifDeltaOutcome::InPlace) : Result::failure(ExifError::WriteFailed);
+}
@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Metadata deltas:
+//
+// Replicates tag edits between identical copies of a file without copying
+// the file. createExifDelta() compares the tags of a file with the edits and
+// records, for every tag that actually changes, the new value and a hash of
+// the value it replaces. The file is identified by the size and a hash of
+// everything except its EXIF segment (the other header segments and the last
+// 4 KB of entropy-coded data), so the identity survives the edit itself.
+//
+// applyExifDelta() checks the identity and the old-value hashes of a replica
+// and then:
+// - patches the values in place when every new value fits into the space of
+//   the old one (same type, same or smaller size; values of up to 4 bytes
+//   always go into the IFD entry itself), writing a few bytes;
+// - otherwise rewrites the file with the APP1 segment grown. New values are
+//   appended to the segment and tags that did not exist get a new IFD0 there,
+//   so none of the existing offsets inside the segment move.
+// Applying a delta twice is detected and reported as AlreadyApplied.
+//
+// Tags are looked up in IFD0 and the Exif sub-IFD, new tags go to IFD0.
+// Values in a record are in the byte order of the file.
+//
+struct ExifTagChange {
+    uint16_t tag = 0;
+    uint16_t type = 0;
+    uint32_t count = 0;
+    uint64_t oldValueHash = 0;          // 0 if the tag did not exist
+    std::vector<uint8_t> value;
+};
+
+struct ExifDeltaRecord {
+    std::string path;
+    uint64_t imageSize = 0;             // File size without the EXIF segment
+    uint64_t identity = 0;
+    bool bigendian = true;              // Byte order of the values
+    std::vector<ExifTagChange> changes;
+};
+
+enum class ExifDeltaOutcome : uint8_t {
+    InPlace,
+    Rewritten,
+    AlreadyApplied
+};
+
+// The value of the result is the number of changed tags (0 = nothing to replicate)
+ExifResult<size_t> createExifDelta(const std::string& path, const ExifBuilder& edits, ExifDeltaRecord& record);
+
+// Compact binary form of a record, records can be concatenated
+void encodeExifDelta(const ExifDeltaRecord& record, std::vector<uint8_t>& output);
+// The value of the result is the number of bytes consumed
+ExifResult<size_t> decodeExifDelta(const uint8_t* data, size_t size, ExifDeltaRecord& record);
+
+// Fails with ExifError::Mismatch if the replica is not the file the delta was
+// made from or one of its tags has been changed differently
+ExifResult<ExifDeltaOutcome> applyExifDelta(const ExifDeltaRecord& record, const std::string& replicaPath);
@@ -0,0 +1,284 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "ExifPresetStore.h"
+
+namespace {
+
+const char storeMagic[8] = { 'M', 'X', 'P', 'R', 'E', 'S', 'E', 'T' };
+
+constexpr uint32_t storeVersion = 1;
+constexpr size_t headerSize = 16;
+constexpr size_t directoryEntrySize = 24;
+constexpr size_t slotSize = 16;
+
+uint16_t getUInt16(const uint8_t* src) {
+	return static_cast<uint16_t>(src[0] | (src[1] << 8));
+}
+
+uint32_t getUInt32(const uint8_t* src) {
+	return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8)
+		| (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+bool inRange(uint64_t offset, uint64_t size, size_t fileSize) {
+	return offset <= fileSize && size <= fileSize - offset;
+}
+
+} // namespace
+
+ExifError ExifPresetWriter::add(const std::string& name, const ExifBuilder& builder, const std::vector<uint16_t>& slotTags) {
+	Preset preset;
+	preset.name = name;
+	preset.blob.resize(builder.exifBlobSize());
+	if (builder.buildExifBlobInto(preset.blob.data(), preset.blob.size()) == 0) {
+		return ExifError::TooLarge;
+	}
+
+	for (uint16_t tag : slotTags) {
+		ExifPresetSlot slot;
+		size_t offset = 0;
+		size_t size = 0;
+		if (!builder.tagValueLocation(tag, offset, size)) {
+			return ExifError::Malformed;
+		}
+		for (const auto& existing : builder.getTags()) {
+			if (existing.tag == tag) {
+				slot.type = existing.type;
+				slot.count = existing.count;
+				break;
+			}
+		}
+		slot.tag = tag;
+		slot.valueOffset = static_cast<uint32_t>(offset);
+		slot.capacity = static_cast<uint32_t>(size);
+		preset.slots.push_back(slot);
+	}
+	presets.push_back(std::move(preset));
+	return ExifError::None;
+}
+
+ExifResult<size_t> ExifPresetWriter::save(const std::string& filename) const {
+	// Header and directory, then name, blob and slot table of each preset
+	std::vector<uint8_t> store(headerSize + presets.size() * directoryEntrySize);
+	std::memcpy(store.data(), storeMagic, 8);
+	ExifBuilder::putUInt32(store.data() + 8, storeVersion, false);
+	ExifBuilder::putUInt32(store.data() + 12, static_cast<uint32_t>(presets.size()), false);
+
+	for (size_t i = 0; i < presets.size(); ++i) {
+		const Preset& preset = presets[i];
+		uint8_t* entry = store.data() + headerSize + i * directoryEntrySize;
+		ExifBuilder::putUInt32(entry, static_cast<uint32_t>(store.size()), false);
+		ExifBuilder::putUInt32(entry + 4, static_cast<uint32_t>(preset.name.size()), false);
+		store.insert(store.end(), preset.name.begin(), preset.name.end());
+
+		// Blobs start on an 8-byte boundary so templates copy aligned data
+		store.resize((store.size() + 7) & ~size_t(7));
+		entry = store.data() + headerSize + i * directoryEntrySize;
+		ExifBuilder::putUInt32(entry + 8, static_cast<uint32_t>(store.size()), false);
+		ExifBuilder::putUInt32(entry + 12, static_cast<uint32_t>(preset.blob.size()), false);
+		store.insert(store.end(), preset.blob.begin(), preset.blob.end());
+
+		store.resize((store.size() + 3) & ~size_t(3));
+		entry = store.data() + headerSize + i * directoryEntrySize;
+		ExifBuilder::putUInt32(entry + 16, static_cast<uint32_t>(store.size()), false);
+		ExifBuilder::putUInt32(entry + 20, static_cast<uint32_t>(preset.slots.size()), false);
+		for (const auto& slot : preset.slots) {
+			uint8_t record[slotSize];
+			ExifBuilder::putUInt16(record, slot.tag, false);
+			ExifBuilder::putUInt16(record + 2, slot.type, false);
+			ExifBuilder::putUInt32(record + 4, slot.count, false);
+			ExifBuilder::putUInt32(record + 8, slot.valueOffset, false);
+			ExifBuilder::putUInt32(record + 12, slot.capacity, false);
+			store.insert(store.end(), record, record + slotSize);
+		}
+	}
+	if (store.size() > UINT32_MAX) {
+		return ExifResult<size_t>::failure(ExifError::TooLarge);
+	}
+
+	FILE* output = fopen(filename.c_str(), "wb");
+	if (!output) {
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
+	}
+	bool written = fwrite(store.data(), 1, store.size(), output) == store.size();
+	if (fclose(output) != 0 || !written) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+	return ExifResult<size_t>::success(store.size());
+}
+
+ExifPresetSlot ExifPresetView::slot(size_t index) const {
+	const uint8_t* record = slotTable + index * slotSize;
+	ExifPresetSlot slot;
+	slot.tag = getUInt16(record);
+	slot.type = getUInt16(record + 2);
+	slot.count = getUInt32(record + 4);
+	slot.valueOffset = getUInt32(record + 8);
+	slot.capacity = getUInt32(record + 12);
+	return slot;
+}
+
+ExifResult<size_t> ExifPresetStore::open(const std::string& filename) {
+	close();
+	auto opened = file.open(filename);
+	if (!opened) {
+		return opened;
+	}
+
+	const uint8_t* data = file.data();
+	size_t size = file.size();
+	if (size < headerSize) {
+		close();
+		return ExifResult<size_t>::failure(ExifError::Truncated, size);
+	}
+	if (std::memcmp(data, storeMagic, 8) != 0 || getUInt32(data + 8) != storeVersion) {
+		close();
+		return ExifResult<size_t>::failure(ExifError::Malformed);
+	}
+
+	// Validate every preset once, so lookups need no bounds checks
+	size_t presets = getUInt32(data + 12);
+	if (!inRange(headerSize, static_cast<uint64_t>(presets) * directoryEntrySize, size)) {
+		close();
+		return ExifResult<size_t>::failure(ExifError::Truncated, headerSize);
+	}
+	for (size_t i = 0; i < presets; ++i) {
+		const uint8_t* entry = data + headerSize + i * directoryEntrySize;
+		uint32_t blobOffset = getUInt32(entry + 8);
+		uint32_t blobSize = getUInt32(entry + 12);
+		uint32_t slotOffset = getUInt32(entry + 16);
+		uint32_t slots = getUInt32(entry + 20);
+		bool valid = inRange(getUInt32(entry), getUInt32(entry + 4), size)
+			&& inRange(blobOffset, blobSize, size)
+			&& inRange(slotOffset, static_cast<uint64_t>(slots) * slotSize, size);
+		for (uint32_t s = 0; valid && s < slots; ++s) {
+			const uint8_t* record = data + slotOffset + s * slotSize;
+			valid = inRange(getUInt32(record + 8), getUInt32(record + 12), blobSize);
+		}
+		if (!valid) {
+			close();
+			return ExifResult<size_t>::failure(ExifError::Malformed, headerSize + i * directoryEntrySize);
+		}
+	}
+	count = presets;
+	return ExifResult<size_t>::success(count);
+}
+
+void ExifPresetStore::close() {
+	file.close();
+	count = 0;
+}
+
+ExifPresetView ExifPresetStore::preset(size_t index) const {
+	const uint8_t* data = file.data();
+	const uint8_t* entry = data + headerSize + index * directoryEntrySize;
+	ExifPresetView view;
+	view.name = reinterpret_cast<const char*>(data + getUInt32(entry));
+	view.nameSize = getUInt32(entry + 4);
+	view.blob = data + getUInt32(entry + 8);
+	view.blobSize = getUInt32(entry + 12);
+	view.slotTable = data + getUInt32(entry + 16);
+	view.slotCount = getUInt32(entry + 20);
+	return view;
+}
+
+bool ExifPresetStore::find(const std::string& name, ExifPresetView& view) const {
+	for (size_t i = 0; i < count; ++i) {
+		ExifPresetView candidate = preset(i);
+		if (candidate.nameSize == name.size() && std::memcmp(candidate.name, name.data(), name.size()) == 0) {
+			view = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ExifTemplate::init(const ExifPresetView& preset) {
+	blob.assign(preset.blob, preset.blob + preset.blobSize);
+	slots.resize(preset.slotCount);
+	for (size_t i = 0; i < preset.slotCount; ++i) {
+		slots[i] = preset.slot(i);
+	}
+}
+
+uint8_t* ExifTemplate::slotValue(uint16_t tag, uint16_t type, size_t offset, size_t size) {
+	for (const auto& slot : slots) {
+		if (slot.tag == tag) {
+			if (slot.type != type || offset + size > slot.capacity) {
+				return nullptr;
+			}
+			return blob.data() + slot.valueOffset + offset;
+		}
+	}
+	return nullptr;
+}
+
+bool ExifTemplate::setString(uint16_t tag, const char* text, size_t length) {
+	for (const auto& slot : slots) {
+		if (slot.tag == tag) {
+			// Keep at least one terminating zero
+			if (slot.type != 0x0002 || length >= slot.capacity) {
+				return false;
+			}
+			uint8_t* value = blob.data() + slot.valueOffset;
+			std::memcpy(value, text, length);
+			std::memset(value + length, 0, slot.capacity - length);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Blobs are built big endian, see ExifBuilder::buildExifBlobInto()
+bool ExifTemplate::setUInt16(uint16_t tag, uint16_t value, size_t index) {
+	uint8_t* dst = slotValue(tag, 0x0003, index * 2, 2);
+	if (!dst) {
+		return false;
+	}
+	ExifBuilder::putUInt16(dst, value, true);
+	return true;
+}
+
+bool ExifTemplate::setUInt32(uint16_t tag, uint32_t value, size_t index) {
+	uint8_t* dst = slotValue(tag, 0x0004, index * 4, 4);
+	if (!dst) {
+		return false;
+	}
+	ExifBuilder::putUInt32(dst, value, true);
+	return true;
+}
+
+bool ExifTemplate::setRational(uint16_t tag, uint32_t numerator, uint32_t denominator, size_t index) {
+	uint8_t* dst = slotValue(tag, 0x0005, index * 8, 8);
+	if (!dst) {
+		return false;
+	}
+	ExifBuilder::putUInt32(dst, numerator, true);
+	ExifBuilder::putUInt32(dst + 4, denominator, true);
+	return true;
+}
@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Precompiled EXIF presets:
+//
+// ExifPresetWriter serializes named presets once (e.g. at install time) into
+// a binary store. Each preset holds the complete APP1 blob built from an
+// ExifBuilder and a table of slots: the tags whose values change per frame,
+// with the position and capacity of their value inside the blob.
+//
+// At startup ExifPresetStore maps the store read-only, so the pages are
+// shared by all worker processes, and ExifTemplate initializes from a preset
+// with a single copy of the blob instead of rebuilding it tag by tag.
+// Slots are then patched in place; the blob size never changes.
+//
+// All numbers in the store are little endian.
+//
+struct ExifPresetSlot {
+    uint16_t tag = 0;
+    uint16_t type = 0;
+    uint32_t count = 0;
+    uint32_t valueOffset = 0;       // Offset of the value inside the blob
+    uint32_t capacity = 0;          // Size of the value in bytes
+};
+
+class ExifPresetWriter {
+public:
+    // Adds a preset. slotTags are the tags that may be patched later; their
+    // current value reserves the capacity (use a padded placeholder for
+    // strings). Fails with Malformed if a slot tag is not set.
+    ExifError add(const std::string& name, const ExifBuilder& builder, const std::vector<uint16_t>& slotTags);
+
+    // The value of the result is the size of the store
+    ExifResult<size_t> save(const std::string& filename) const;
+
+private:
+    struct Preset {
+        std::string name;
+        std::vector<uint8_t> blob;
+        std::vector<ExifPresetSlot> slots;
+    };
+    std::vector<Preset> presets;
+};
+
+// Read-only view of a preset inside a mapped store
+struct ExifPresetView {
+    const char* name = nullptr;
+    size_t nameSize = 0;
+    const uint8_t* blob = nullptr;
+    size_t blobSize = 0;
+    const uint8_t* slotTable = nullptr;
+    size_t slotCount = 0;
+
+    ExifPresetSlot slot(size_t index) const;
+};
+
+class ExifPresetStore {
+public:
+    // Maps and validates the store. The value of the result is the number of presets.
+    ExifResult<size_t> open(const std::string& filename);
+    void close();
+
+    size_t presetCount() const { return count; }
+    ExifPresetView preset(size_t index) const;
+    // Returns false if there is no preset with this name
+    bool find(const std::string& name, ExifPresetView& view) const;
+
+private:
+    MappedFile file;
+    size_t count = 0;
+};
+
+class ExifTemplate {
+public:
+    ExifTemplate() = default;
+    explicit ExifTemplate(const ExifPresetView& preset) {
+        init(preset);
+    }
+
+    void init(const ExifPresetView& preset);
+
+    // Patch slot values, returning false if the tag has no slot or the value
+    // does not match its type or capacity. Strings shorter than the slot are
+    // padded with zeros, longer ones are rejected.
+    bool setString(uint16_t tag, const char* text, size_t length);
+    bool setUInt16(uint16_t tag, uint16_t value, size_t index = 0);
+    bool setUInt32(uint16_t tag, uint32_t value, size_t index = 0);
+    bool setRational(uint16_t tag, uint32_t numerator, uint32_t denominator, size_t index = 0);
+
+    const uint8_t* data() const { return blob.data(); }
+    size_t size() const { return blob.size(); }
+
+private:
+    uint8_t* slotValue(uint16_t tag, uint16_t type, size_t offset, size_t size);
+
+    std::vector<uint8_t> blob;
+    std::vector<ExifPresetSlot> slots;
+};
@@ -0,0 +1,181 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstring>
+
+#include "ExifStreamInjector.h"
+
+ExifStreamInjector::ExifStreamInjector(const uint8_t* exifBlob, size_t exifSize, Sink sink, bool multiFrame, size_t maxHeaderSize)
+	: blob(exifBlob, exifBlob + exifSize), sink(std::move(sink)), multiFrame(multiFrame), maxHeaderSize(maxHeaderSize) {
+}
+
+void ExifStreamInjector::reset() {
+	header.clear();
+	layout.reset();
+	inHeader = true;
+	pendingFF = false;
+	emitted = 0;
+	frames = 0;
+	error = ExifError::None;
+}
+
+void ExifStreamInjector::setExifBlob(const uint8_t* exifBlob, size_t exifSize) {
+	blob.assign(exifBlob, exifBlob + exifSize);
+}
+
+ExifResult<size_t> ExifStreamInjector::fail(ExifError failure, size_t offset) {
+	error = failure;
+	return ExifResult<size_t>::failure(failure, offset);
+}
+
+void ExifStreamInjector::emit(const uint8_t* data, size_t size) {
+	if (size > 0) {
+		sink(data, size);
+		emitted += size;
+	}
+}
+
+// Forwards entropy-coded data. In multiFrame mode stops right after an EOI
+// marker and returns the number of bytes consumed.
+size_t ExifStreamInjector::passThrough(const uint8_t* chunk, size_t size) {
+	if (!multiFrame) {
+		emit(chunk, size);
+		return size;
+	}
+
+	// Byte stuffing guarantees that FF D9 inside a frame is only its EOI
+	size_t pos = 0;
+	bool eoi = pendingFF && size > 0 && chunk[0] == 0xD9;
+	if (eoi) {
+		pos = 1;
+	}
+	pendingFF = false;
+	while (!eoi && pos < size) {
+		const void* ff = std::memchr(chunk + pos, 0xFF, size - pos);
+		if (!ff) {
+			pos = size;
+			break;
+		}
+		pos = static_cast<const uint8_t*>(ff) - chunk + 1;
+		if (pos == size) {
+			pendingFF = true;
+		}
+		else if (chunk[pos] == 0xD9) {
+			++pos;
+			eoi = true;
+		}
+	}
+
+	emit(chunk, pos);
+	if (!eoi) {
+		return pos;
+	}
+
+	// EOI found: the frame is complete
+	inHeader = true;
+	layout.reset();
+	++frames;
+	return pos;
+}
+
+ExifResult<size_t> ExifStreamInjector::feed(const uint8_t* chunk, size_t size) {
+	if (error != ExifError::None) {
+		return ExifResult<size_t>::failure(error, emitted);
+	}
+
+	while (size > 0) {
+		if (!inHeader) {
+			size_t used = passThrough(chunk, size);
+			chunk += used;
+			size -= used;
+			continue;
+		}
+
+		// The header is held back until the walk reaches SOS. A header that
+		// arrives within one chunk is emitted straight from the chunk.
+		size_t before = header.size();
+		const uint8_t* data = chunk;
+		size_t available = size;
+		if (before > 0) {
+			header.insert(header.end(), chunk, chunk + size);
+			data = header.data();
+			available = header.size();
+		}
+		// A frame start goes through the layout cache, a header split over
+		// chunks is walked incrementally
+		ExifResult<size_t> scan;
+		if (before == 0) {
+			auto cached = layouts.lookup(data, available);
+			if (cached) {
+				layout = *cached.value;
+				scan.value = layout.insertOffset;
+			}
+			else {
+				scan = ExifResult<size_t>::failure(cached.error, cached.offset);
+			}
+		}
+		else {
+			scan = scanJpegHeader(data, available, layout);
+		}
+		if (!scan) {
+			if (scan.error != ExifError::Truncated) {
+				return fail(scan.error, emitted + scan.offset);
+			}
+			if (before == 0) {
+				header.assign(chunk, chunk + size);
+			}
+			if (header.size() > maxHeaderSize) {
+				return fail(ExifError::Malformed, emitted + header.size());
+			}
+			return ExifResult<size_t>::success(emitted);
+		}
+
+		// Header complete: emit it with the blob, keep the rest of the chunk
+		size_t insertAt = layout.insertOffset;
+		emit(data, insertAt);
+		emit(blob.data(), blob.size());
+		emit(data + insertAt, layout.headerSize - insertAt);
+		inHeader = false;
+
+		size_t used = layout.headerSize - before;
+		header.clear();
+		chunk += used;
+		size -= used;
+		if (!multiFrame) {
+			++frames;
+		}
+	}
+	return ExifResult<size_t>::success(emitted);
+}
+
+ExifResult<size_t> ExifStreamInjector::finish() {
+	if (error != ExifError::None) {
+		return ExifResult<size_t>::failure(error, emitted);
+	}
+	// In multiFrame mode a frame is complete only with its EOI
+	if (!header.empty() || (frames == 0 && inHeader) || (multiFrame && !inHeader)) {
+		return fail(ExifError::Truncated, emitted + header.size());
+	}
+	return ExifResult<size_t>::success(emitted);
+}
@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "JpegHeader.h"
+#include "JpegSpliceCache.h"
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// ExifStreamInjector:
+//
+// Push-style injector for encoders that deliver their output in chunks.
+// feed() holds back bytes only until the JPEG header has been walked up to
+// SOS, then emits the header with the EXIF blob at the insertion point (see
+// JpegHeader.h) and passes every following chunk straight to the sink.
+// Memory and latency are therefore bounded by the header size, not by the
+// frame size.
+//
+// In multiFrame mode the injector handles a stream of concatenated JPEGs
+// (MJPEG): after an EOI marker it starts over with the next frame.
+//
+// A header that arrives within one chunk is looked up in a JpegSpliceCache,
+// so the frames of one encoder (and streams after reset()) skip the walk.
+// Headers split over several chunks are walked incrementally.
+//
+//   ExifStreamInjector injector(blob.data(), blob.size(), [&](const uint8_t* data, size_t size) {
+//       fwrite(data, 1, size, out);
+//   });
+//   while (encoder delivers chunk) injector.feed(chunk, chunkSize);
+//   injector.finish();
+//
+class ExifStreamInjector {
+public:
+    using Sink = std::function<void(const uint8_t* data, size_t size)>;
+
+    ExifStreamInjector(const uint8_t* exifBlob, size_t exifSize, Sink sink, bool multiFrame = false, size_t maxHeaderSize = 1 << 20);
+
+    // Processes the next chunk. On failure the injector stays failed until reset().
+    // The value of the result is the number of bytes emitted so far.
+    ExifResult<size_t> feed(const uint8_t* chunk, size_t size);
+
+    // Ends the stream, fails with ExifError::Truncated if it ended inside a
+    // header or, in multiFrame mode, inside a frame
+    ExifResult<size_t> finish();
+
+    // Prepares for the next stream, the blob and the sink are kept
+    void reset();
+
+    // Replaces the blob for the following frames, e.g. with a new timestamp
+    void setExifBlob(const uint8_t* exifBlob, size_t exifSize);
+
+    size_t framesDone() const { return frames; }
+
+private:
+    ExifResult<size_t> fail(ExifError error, size_t offset);
+    void emit(const uint8_t* data, size_t size);
+    size_t passThrough(const uint8_t* chunk, size_t size);
+
+    std::vector<uint8_t> blob;
+    Sink sink;
+    bool multiFrame;
+    size_t maxHeaderSize;
+
+    std::vector<uint8_t> header;        // Held back bytes of the current frame
+    JpegHeaderLayout layout;
+    JpegSpliceCache layouts{ 4 };       // Kept across frames and reset()
+    bool inHeader = true;
+    bool pendingFF = false;             // Last passed byte was 0xFF (EOI detection)
+    size_t emitted = 0;
+    size_t frames = 0;
+    ExifError error = ExifError::None;
+};
@@ -0,0 +1,346 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define MICROEXIF_SSSE3
+#endif
+
+#include "ExifTranscoder.h"
+#include "JpegHeader.h"
+#include "MicroExifProbes.h"
+
+namespace {
+
+constexpr uint16_t exifIfdTag = 0x8769;
+constexpr uint16_t gpsIfdTag = 0x8825;
+constexpr uint16_t interopIfdTag = 0xA005;
+constexpr size_t maxIfds = 16;
+constexpr size_t segmentHeaderSize = 10;   // Marker, length, "Exif\0\0"
+
+// Bytes per element and per swapped unit, e.g. RATIONAL = two 4-byte units
+bool typeLayout(uint16_t type, size_t& elementSize, size_t& unitSize) {
+	switch (type) {
+	case 0x0001: // BYTE
+	case 0x0002: // ASCII
+	case 0x0006: // SBYTE
+	case 0x0007: // UNDEFINED
+		elementSize = unitSize = 1;
+		return true;
+	case 0x0003: // SHORT
+	case 0x0008: // SSHORT
+		elementSize = unitSize = 2;
+		return true;
+	case 0x0004: // LONG
+	case 0x0009: // SLONG
+	case 0x000B: // FLOAT
+	case 0x000D: // IFD
+		elementSize = unitSize = 4;
+		return true;
+	case 0x0005: // RATIONAL
+	case 0x000A: // SRATIONAL
+		elementSize = 8;
+		unitSize = 4;
+		return true;
+	case 0x000C: // DOUBLE
+		elementSize = unitSize = 8;
+		return true;
+	}
+	return false;
+}
+
+uint16_t getUInt16(const uint8_t* src, bool bigendian) {
+	return static_cast<uint16_t>(bigendian ? (src[0] << 8) | src[1] : (src[1] << 8) | src[0]);
+}
+
+uint32_t getUInt32(const uint8_t* src, bool bigendian) {
+	return bigendian
+		? (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 8) | src[3]
+		: (static_cast<uint32_t>(src[3]) << 24) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[1]) << 8) | src[0];
+}
+
+// Reverses every unit-byte group of src into dst, size is a multiple of unit
+void swapUnits(const uint8_t* src, uint8_t* dst, size_t size, size_t unit) {
+	if (unit == 1) {
+		return;
+	}
+	size_t i = 0;
+#ifdef MICROEXIF_SSSE3
+	if (size >= 16) {
+		const __m128i mask = unit == 2 ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+			: unit == 4 ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+			: _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for (; i + 16 <= size; i += 16) {
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(value, mask));
+		}
+	}
+#endif
+	for (; i < size; i += unit) {
+		for (size_t byte = 0; byte < unit; ++byte) {
+			dst[i + byte] = src[i + unit - 1 - byte];
+		}
+	}
+}
+
+struct TiffTranscoder {
+	const uint8_t* src = nullptr;
+	uint8_t* dst = nullptr;
+	size_t size = 0;
+	bool bigendian = true;              // Of the source
+	uint32_t visited[maxIfds];          // No allocation on the way
+	size_t visitedCount = 0;
+	std::pair<size_t, size_t> used[64];             // IFD tables and values, [begin, end)
+	size_t usedCount = 0;
+	std::vector<std::pair<size_t, size_t>> moreUsed;    // Beyond the first 64
+	size_t subIfdEnds[maxIfds];         // Possible next pointers of sub-IFDs
+	size_t subIfdCount = 0;
+	size_t entries = 0;
+	size_t errorOffset = 0;
+
+	void markUsed(size_t begin, size_t end) {
+		if (usedCount < 64) {
+			used[usedCount++] = { begin, end };
+		}
+		else {
+			moreUsed.push_back({ begin, end });
+		}
+	}
+
+	bool isUsed(size_t begin, size_t end) const {
+		for (size_t i = 0; i < usedCount; ++i) {
+			if (begin < used[i].second && used[i].first < end) {
+				return true;
+			}
+		}
+		for (const auto& range : moreUsed) {
+			if (begin < range.second && range.first < end) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	ExifError fail(size_t offset) {
+		errorOffset = offset;
+		return ExifError::Malformed;
+	}
+
+	// IFD0 and IFD1 form the main chain and always end with a next pointer,
+	// IFD1 is only followed from IFD0
+	ExifError ifd(uint32_t offset, bool inChain, bool followNext) {
+		for (size_t i = 0; i < visitedCount; ++i) {
+			if (visited[i] == offset) {
+				return ExifError::None;
+			}
+		}
+		// Offsets below 8 would walk the TIFF header as an IFD
+		if (visitedCount >= maxIfds || offset < 8 || offset + 2ull > size) {
+			return fail(offset);
+		}
+		visited[visitedCount++] = offset;
+
+		size_t count = getUInt16(src + offset, bigendian);
+		size_t end = offset + 2 + count * 12;
+		if (end > size || (inChain && end + 4 > size)) {
+			return fail(offset);
+		}
+		swapUnits(src + offset, dst + offset, 2, 2);
+		markUsed(offset, end);
+
+		uint32_t children[3];
+		size_t childCount = 0;
+		for (size_t i = 0; i < count; ++i) {
+			size_t entry = offset + 2 + i * 12;
+			uint16_t tag = getUInt16(src + entry, bigendian);
+			uint16_t type = getUInt16(src + entry + 2, bigendian);
+			uint32_t elements = getUInt32(src + entry + 4, bigendian);
+			size_t elementSize = 0;
+			size_t unitSize = 0;
+			if (!typeLayout(type, elementSize, unitSize)) {
+				return fail(entry);
+			}
+			swapUnits(src + entry, dst + entry, 4, 2);
+			swapUnits(src + entry + 4, dst + entry + 4, 4, 4);
+
+			uint64_t valueSize = static_cast<uint64_t>(elements) * elementSize;
+			size_t valueOffset = entry + 8;
+			if (valueSize > 4) {
+				valueOffset = getUInt32(src + entry + 8, bigendian);
+				if (valueOffset + valueSize > size) {
+					return fail(entry);
+				}
+				swapUnits(src + entry + 8, dst + entry + 8, 4, 4);
+				markUsed(valueOffset, static_cast<size_t>(valueOffset + valueSize));
+			}
+			swapUnits(src + valueOffset, dst + valueOffset, static_cast<size_t>(valueSize), unitSize);
+
+			if ((tag == exifIfdTag || tag == gpsIfdTag || tag == interopIfdTag) && elementSize == 4 && elements >= 1 && childCount < 3) {
+				children[childCount++] = getUInt32(src + valueOffset, bigendian);
+			}
+		}
+		entries += count;
+
+		uint32_t next = 0;
+		if (inChain) {
+			next = getUInt32(src + end, bigendian);
+			swapUnits(src + end, dst + end, 4, 4);
+			markUsed(end, end + 4);
+		}
+		else if (end + 4 <= size) {
+			// Some writers end sub-IFDs without a next pointer, the bytes are
+			// only swapped if no value turns out to use them (nextPointers())
+			subIfdEnds[subIfdCount++] = end;
+		}
+		for (size_t i = 0; i < childCount; ++i) {
+			ExifError error = ifd(children[i], false, false);
+			if (error != ExifError::None) {
+				return error;
+			}
+		}
+		return followNext && next != 0 ? ifd(next, true, false) : ExifError::None;
+	}
+
+	// After the walk, when all used ranges are known
+	void nextPointers() {
+		for (size_t i = 0; i < subIfdCount; ++i) {
+			size_t pointer = subIfdEnds[i];
+			if (!isUsed(pointer, pointer + 4)) {
+				swapUnits(src + pointer, dst + pointer, 4, 4);
+			}
+		}
+	}
+};
+
+} // namespace
+
+ExifResult<size_t> transcodeTiff(const uint8_t* tiff, size_t size, uint8_t* output, bool bigendian) {
+	if (size < 8) {
+		return ExifResult<size_t>::failure(ExifError::Truncated, size);
+	}
+	bool sourceBigendian = tiff[0] == 'M';
+	if (!(tiff[0] == tiff[1] && (tiff[0] == 'M' || tiff[0] == 'I')) || getUInt16(tiff + 2, sourceBigendian) != 42) {
+		return ExifResult<size_t>::failure(ExifError::Malformed, 0);
+	}
+	std::memcpy(output, tiff, size);
+	if (sourceBigendian == bigendian) {
+		return ExifResult<size_t>::success(0);
+	}
+
+	output[0] = output[1] = bigendian ? 'M' : 'I';
+	ExifBuilder::putUInt16(output + 2, 42, bigendian);
+	swapUnits(tiff + 4, output + 4, 4, 4);
+
+	TiffTranscoder transcoder;
+	transcoder.src = tiff;
+	transcoder.dst = output;
+	transcoder.size = size;
+	transcoder.bigendian = sourceBigendian;
+	ExifError error = transcoder.ifd(getUInt32(tiff + 4, sourceBigendian), true, true);
+	if (error != ExifError::None) {
+		return ExifResult<size_t>::failure(error, transcoder.errorOffset);
+	}
+	transcoder.nextPointers();
+	return ExifResult<size_t>::success(transcoder.entries);
+}
+
+ExifResult<size_t> transcodeExifSegment(const uint8_t* segment, size_t size, uint8_t* output, bool bigendian) {
+	if (size < segmentHeaderSize) {
+		return ExifResult<size_t>::failure(ExifError::Truncated, size);
+	}
+	if (segment[0] != 0xFF || segment[1] != 0xE1 || std::memcmp(segment + 4, "Exif\0\0", 6) != 0) {
+		return ExifResult<size_t>::failure(ExifError::Malformed, 0);
+	}
+	std::memcpy(output, segment, segmentHeaderSize);
+	auto result = transcodeTiff(segment + segmentHeaderSize, size - segmentHeaderSize, output + segmentHeaderSize, bigendian);
+	if (!result) {
+		return ExifResult<size_t>::failure(result.error, result.offset + segmentHeaderSize);
+	}
+	return result;
+}
+
+ExifResult<ByteOrderReport> normalizeJpegByteOrder(const std::string& originalFile, const std::string& newFile, bool bigendian) {
+	using Result = ExifResult<ByteOrderReport>;
+	MicroExifWriteProbes probes;
+	FILE* input = fopen(originalFile.c_str(), "rb");
+	if (!input) {
+		return Result::failure(ExifError::OpenFailed);
+	}
+
+	std::vector<uint8_t> buffer;
+	JpegHeaderLayout layout;
+	auto scanned = readJpegHeader(input, buffer, layout);
+	if (!scanned) {
+		fclose(input);
+		return Result::failure(scanned.error, scanned.offset);
+	}
+	ByteOrderReport report;
+	std::vector<uint8_t> converted;
+	for (const auto& segment : layout.segments) {
+		if (!isJpegAppSegment(buffer.data(), segment, 0xE1, "Exif\0", 6)) {
+			continue;
+		}
+		converted.resize(segment.length);
+		auto result = transcodeExifSegment(buffer.data() + segment.offset, segment.length, converted.data(), bigendian);
+		if (!result) {
+			fclose(input);
+			return Result::failure(result.error, segment.offset + result.offset);
+		}
+		if (result.value != 0) {
+			std::memcpy(buffer.data() + segment.offset, converted.data(), segment.length);
+			++report.segments;
+			report.entries += result.value;
+		}
+	}
+
+	FILE* output = fopen(newFile.c_str(), "wb");
+	if (!output) {
+		fclose(input);
+		return Result::failure(ExifError::CreateFailed);
+	}
+	// No blob is inserted, the segments are rewritten in place
+	probes.writeStart(originalFile, 0);
+	// The converted part of the file already read, then the rest
+	bool written = fwrite(buffer.data(), 1, buffer.size(), output) == buffer.size();
+	report.fileSize = buffer.size();
+	buffer.resize(256 * 1024);
+	size_t read = 0;
+	while (written && (read = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+		written = fwrite(buffer.data(), 1, read, output) == read;
+		report.fileSize += read;
+	}
+	bool readFailed = ferror(input) != 0;
+	written = (fclose(output) == 0) && written;
+	fclose(input);
+	if (readFailed || !written) {
+		return Result::failure(readFailed ? ExifError::ReadFailed : ExifError::WriteFailed);
+	}
+	probes.done(newFile.c_str(), report.fileSize);
+	return Result::success(report);
+}
@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Byte-order transcoder:
+//
+// Rewrites the TIFF structure of an EXIF segment from Motorola ("MM") to
+// Intel ("II") order or back. The layout does not change: every IFD, value
+// and offset stays where it is and only the bytes of numeric fields are
+// swapped. The walk covers IFD0, the Exif (0x8769), GPS (0x8825) and
+// Interoperability (0xA005) sub-IFDs and IFD1, whose thumbnail offsets are
+// relative to the TIFF header and therefore stay valid.
+//
+// BYTE, ASCII and UNDEFINED values are copied verbatim, which includes the
+// thumbnail and maker notes (their private IFDs keep the camera's order).
+// Arrays of SHORT, LONG, RATIONAL, FLOAT and DOUBLE values are swapped 16
+// bytes at a time with pshufb when the compiler targets SSSE3, and with a
+// scalar loop otherwise.
+//
+enum class ExifByteOrder : uint8_t {
+    Keep,
+    BigEndian,                          // Motorola, "MM"
+    LittleEndian                        // Intel, "II"
+};
+
+// tiff points to the byte order mark, output receives size bytes and must
+// not overlap the input. The value of the result is the number of IFD
+// entries converted, 0 if the input already has the target order.
+ExifResult<size_t> transcodeTiff(const uint8_t* tiff, size_t size, uint8_t* output, bool bigendian);
+
+// Same for an APP1 segment from its 0xFF marker on, as built by ExifBuilder
+// or found in a file
+ExifResult<size_t> transcodeExifSegment(const uint8_t* segment, size_t size, uint8_t* output, bool bigendian);
+
+struct ByteOrderReport {
+    size_t segments = 0;                // EXIF segments converted, 0 = copied unchanged
+    size_t entries = 0;
+    size_t fileSize = 0;
+};
+
+// Copies originalFile to newFile with all EXIF segments in the given order.
+// Only the header is parsed, the rest of the file is streamed.
+ExifResult<ByteOrderReport> normalizeJpegByteOrder(const std::string& originalFile, const std::string& newFile, bool bigendian);
@@ -0,0 +1,289 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+#include "FileCrawler.h"
+
+namespace {
+
+struct CrawlCounters {
+	std::atomic<size_t> directories{ 0 };
+	std::atomic<size_t> entries{ 0 };
+	std::atomic<size_t> matched{ 0 };
+	std::atomic<size_t> statCalls{ 0 };
+	std::atomic<size_t> errors{ 0 };
+	std::atomic<bool> stop{ false };
+};
+
+// Counts a match, false once options.maxFiles have been reported
+bool acceptMatch(const CrawlOptions& options, CrawlCounters& counters) {
+	size_t matched = counters.matched.fetch_add(1, std::memory_order_relaxed);
+	if (options.maxFiles != 0 && matched >= options.maxFiles) {
+		counters.matched.fetch_sub(1, std::memory_order_relaxed);
+		counters.stop.store(true, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool hasExtension(const char* name, size_t length, const std::vector<std::string>& extensions) {
+	if (extensions.empty()) {
+		return true;
+	}
+	for (const auto& extension : extensions) {
+		if (length <= extension.size()) {
+			continue;
+		}
+		const char* suffix = name + length - extension.size();
+		size_t i = 0;
+		while (i < extension.size() && std::tolower(static_cast<unsigned char>(suffix[i])) == std::tolower(static_cast<unsigned char>(extension[i]))) {
+			++i;
+		}
+		if (i == extension.size()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool isJpegMagic(const unsigned char* magic) {
+	return magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF;
+}
+
+#ifdef __linux__
+
+struct LinuxDirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[1];
+};
+
+// Resolves the type of an entry whose d_type is not known
+unsigned char statType(int dirFd, const char* name, bool follow, CrawlCounters& counters) {
+	counters.statCalls.fetch_add(1, std::memory_order_relaxed);
+	int flags = follow ? 0 : AT_SYMLINK_NOFOLLOW;
+#ifdef STATX_TYPE
+	struct statx info;
+	if (statx(dirFd, name, flags | AT_STATX_DONT_SYNC, STATX_TYPE, &info) != 0) {
+		return DT_UNKNOWN;
+	}
+	mode_t mode = info.stx_mode;
+#else
+	struct stat info;
+	if (fstatat(dirFd, name, &info, flags) != 0) {
+		return DT_UNKNOWN;
+	}
+	mode_t mode = info.st_mode;
+#endif
+	return S_ISDIR(mode) ? DT_DIR : S_ISREG(mode) ? DT_REG : S_ISLNK(mode) ? DT_LNK : DT_UNKNOWN;
+}
+
+bool hasJpegMagic(int dirFd, const char* name) {
+	int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC | O_NOCTTY);
+	if (fd < 0) {
+		return false;
+	}
+	unsigned char magic[3];
+	bool jpeg = pread(fd, magic, 3, 0) == 3 && isJpegMagic(magic);
+	close(fd);
+	return jpeg;
+}
+
+void listDirectory(const std::string& path, const CrawlOptions& options, const CrawlSink& sink, std::vector<std::string>& subdirectories, CrawlCounters& counters) {
+	int dirFd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd < 0) {
+		counters.errors.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	alignas(8) char buffer[64 * 1024];
+	while (!counters.stop.load(std::memory_order_relaxed)) {
+		long bytes = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+		if (bytes <= 0) {
+			if (bytes < 0) {
+				counters.errors.fetch_add(1, std::memory_order_relaxed);
+			}
+			break;
+		}
+		for (long position = 0; position < bytes;) {
+			const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer + position);
+			position += entry->d_reclen;
+			const char* name = entry->d_name;
+			if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) {
+				continue;
+			}
+			counters.entries.fetch_add(1, std::memory_order_relaxed);
+
+			unsigned char type = entry->d_type;
+			if (type == DT_UNKNOWN || (type == DT_LNK && options.followSymlinks)) {
+				type = statType(dirFd, name, options.followSymlinks, counters);
+			}
+
+			if (type == DT_DIR) {
+				subdirectories.push_back(path + "/" + name);
+			}
+			else if (type == DT_REG) {
+				if (hasExtension(name, std::strlen(name), options.extensions) && (!options.checkMagic || hasJpegMagic(dirFd, name))) {
+					if (!acceptMatch(options, counters)) {
+						break;
+					}
+					sink(path + "/" + name);
+				}
+			}
+		}
+	}
+	close(dirFd);
+}
+
+#else
+
+void listDirectory(const std::string& path, const CrawlOptions& options, const CrawlSink& sink, std::vector<std::string>& subdirectories, CrawlCounters& counters) {
+	std::error_code error;
+	std::filesystem::directory_iterator it(path, error);
+	if (error) {
+		counters.errors.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	for (const auto& entry : it) {
+		counters.entries.fetch_add(1, std::memory_order_relaxed);
+		bool symlink = entry.is_symlink(error);
+		if (symlink && !options.followSymlinks) {
+			continue;
+		}
+		std::string entryPath = entry.path().string();
+		if (entry.is_directory(error)) {
+			subdirectories.push_back(std::move(entryPath));
+		}
+		else if (entry.is_regular_file(error)) {
+			if (!hasExtension(entryPath.c_str(), entryPath.size(), options.extensions)) {
+				continue;
+			}
+			if (options.checkMagic) {
+				unsigned char magic[3] = {};
+				FILE* file = fopen(entryPath.c_str(), "rb");
+				bool jpeg = file && fread(magic, 1, 3, file) == 3 && isJpegMagic(magic);
+				if (file) {
+					fclose(file);
+				}
+				if (!jpeg) {
+					continue;
+				}
+			}
+			if (!acceptMatch(options, counters)) {
+				break;
+			}
+			sink(std::move(entryPath));
+		}
+	}
+}
+
+#endif
+
+} // namespace
+
+CrawlStats crawlDirectory(const std::string& root, const CrawlOptions& options, const CrawlSink& sink) {
+	unsigned threads = options.threads ? options.threads : std::min(16u, std::max(1u, std::thread::hardware_concurrency()));
+
+	// Directories waiting to be listed, and the number being listed right now.
+	// The crawl is done when both are zero.
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::string> pending;
+	size_t active = 0;
+	CrawlCounters counters;
+
+	std::string start = root;
+	while (start.size() > 1 && (start.back() == '/' || start.back() == '\\')) {
+		start.pop_back();
+	}
+	pending.push_back(start);
+
+	auto worker = [&](unsigned index) {
+		applyThreadPlacement(options.placement, index);
+		std::vector<std::string> subdirectories;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			wake.wait(lock, [&]() { return !pending.empty() || active == 0; });
+			if (pending.empty()) {
+				break;
+			}
+			// Depth-first keeps the queue small on deep trees
+			std::string path = std::move(pending.back());
+			pending.pop_back();
+			++active;
+			lock.unlock();
+
+			if (!counters.stop.load(std::memory_order_relaxed)) {
+				counters.directories.fetch_add(1, std::memory_order_relaxed);
+				listDirectory(path, options, sink, subdirectories, counters);
+			}
+
+			lock.lock();
+			for (auto& subdirectory : subdirectories) {
+				pending.push_back(std::move(subdirectory));
+			}
+			subdirectories.clear();
+			--active;
+			wake.notify_all();
+		}
+	};
+
+	// The calling thread only waits, so a placement never sticks to it
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < threads; ++i) {
+		workers.emplace_back(worker, i);
+	}
+	for (auto& thread : workers) {
+		thread.join();
+	}
+
+	CrawlStats stats;
+	stats.directories = counters.directories;
+	stats.entries = counters.entries;
+	stats.matched = counters.matched;
+	stats.statCalls = counters.statCalls;
+	stats.errors = counters.errors;
+	return stats;
+}
@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ThreadPlacement.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// FileCrawler:
+//
+// Parallel discovery of input files for batch runs. Directories are shared
+// through a work queue and listed by a pool of threads. On Linux a directory
+// is read with raw getdents64 calls into a 64 KB buffer and the entry type
+// comes from d_type; statx is only called for file systems that report
+// DT_UNKNOWN (and for symbolic links when they are followed). Elsewhere
+// std::filesystem::directory_iterator is used.
+//
+// Matching files are handed to the sink while the crawl is still running,
+// so the consumers can start before the tree has been enumerated. The sink
+// is called concurrently from the crawler threads.
+//
+struct CrawlOptions {
+    unsigned threads = 0;                   // 0 = one per core, at most 16
+    std::vector<std::string> extensions = { ".jpg", ".jpeg" };     // Case-insensitive, empty = all files
+    bool checkMagic = false;                // Also require the file to start with FF D8 FF
+    bool followSymlinks = false;
+    ThreadPlacement placement;              // Of the crawler threads
+    size_t maxFiles = 0;                    // Stop after this many matches, 0 = no limit
+};
+
+struct CrawlStats {
+    size_t directories = 0;
+    size_t entries = 0;                     // Directory entries seen (without . and ..)
+    size_t matched = 0;                     // Files passed to the sink
+    size_t statCalls = 0;                   // Entries that needed a statx
+    size_t errors = 0;                      // Directories or files that could not be read
+};
+
+using CrawlSink = std::function<void(std::string&& path)>;
+
+CrawlStats crawlDirectory(const std::string& root, const CrawlOptions& options, const CrawlSink& sink);
@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "FrontLoader.h"
+#include "MicroExifProbes.h"
+
+ExifResult<FrontLoadReport> buildFrontLoadedHeader(const uint8_t* jpeg, const JpegHeaderLayout& layout, const uint8_t* exifBlob, size_t exifSize,
+	std::vector<uint8_t>& header, const FrontLoadOptions& options) {
+	using Result = ExifResult<FrontLoadReport>;
+	if (!layout.complete || layout.segments.empty()) {
+		return Result::failure(ExifError::Truncated);
+	}
+
+	FrontLoadReport report;
+	header.clear();
+	header.reserve(layout.insertOffset + exifSize);
+	header.push_back(0xFF);
+	header.push_back(0xD8);
+
+	// Leading APP0 segments stay in front, JFIF requires it
+	size_t index = 1;
+	while (index < layout.segments.size() && layout.segments[index].marker == 0xE0 && layout.segments[index].offset < layout.insertOffset) {
+		const JpegSegment& segment = layout.segments[index++];
+		header.insert(header.end(), jpeg + segment.offset, jpeg + segment.offset + segment.length);
+	}
+
+	report.exifOffset = header.size();
+	header.insert(header.end(), exifBlob, exifBlob + exifSize);
+	report.exifEnd = header.size();
+	report.withinLimit = report.exifEnd <= options.limit;
+
+	for (; index < layout.segments.size() && layout.segments[index].offset < layout.insertOffset; ++index) {
+		const JpegSegment& segment = layout.segments[index];
+		if (!options.keepOldExif && isJpegAppSegment(jpeg, segment, 0xE1, "Exif\0", 6)) {
+			++report.droppedSegments;
+			continue;
+		}
+		header.insert(header.end(), jpeg + segment.offset, jpeg + segment.offset + segment.length);
+		++report.movedSegments;
+	}
+	return Result::success(report);
+}
+
+ExifResult<FrontLoadReport> writeFrontLoadedJpeg(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize,
+	const FrontLoadOptions& options) {
+	using Result = ExifResult<FrontLoadReport>;
+	MicroExifWriteProbes probes;
+	FILE* input = fopen(originalFile.c_str(), "rb");
+	if (!input) {
+		return Result::failure(ExifError::OpenFailed);
+	}
+
+	std::vector<uint8_t> buffer;
+	JpegHeaderLayout layout;
+	auto scanned = readJpegHeader(input, buffer, layout);
+	if (!scanned) {
+		fclose(input);
+		return Result::failure(scanned.error, scanned.offset);
+	}
+	std::vector<uint8_t> header;
+	auto report = buildFrontLoadedHeader(buffer.data(), layout, exifBlob, exifSize, header, options);
+	if (!report) {
+		fclose(input);
+		return report;
+	}
+
+	FILE* output = fopen(newFile.c_str(), "wb");
+	if (!output) {
+		fclose(input);
+		return Result::failure(ExifError::CreateFailed);
+	}
+	probes.writeStart(originalFile, exifSize);
+	// New header, the part of the file already read, then the rest
+	size_t rest = buffer.size() - layout.insertOffset;
+	bool written = fwrite(header.data(), 1, header.size(), output) == header.size()
+		&& fwrite(buffer.data() + layout.insertOffset, 1, rest, output) == rest;
+	report.value.fileSize = header.size() + rest;
+	buffer.resize(256 * 1024);
+	size_t read = 0;
+	while (written && (read = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+		written = fwrite(buffer.data(), 1, read, output) == read;
+		report.value.fileSize += read;
+	}
+	bool readFailed = ferror(input) != 0;
+	written = (fclose(output) == 0) && written;
+	fclose(input);
+	if (readFailed || !written) {
+		return Result::failure(readFailed ? ExifError::ReadFailed : ExifError::WriteFailed);
+	}
+	probes.done(newFile.c_str(), report.value.fileSize);
+	return report;
+}
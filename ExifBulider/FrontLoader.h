@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JpegHeader.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Front-loaded injection:
+//
+// Range readers and thumbnailers read the first few KB of a file. When the
+// EXIF segment sits behind a large ICC profile (APP2) or Photoshop block
+// (APP13) they need a second request. Front-loading rewrites the metadata
+// part of the header (SOI up to the first segment that is not APPn or COM)
+// in this order:
+//
+//   SOI, leading APP0 (JFIF/JFXX), the new EXIF blob, all other APPn/COM
+//   segments in their original order
+//
+// Existing EXIF segments are dropped unless keepOldExif is set. Everything
+// from the first table segment on is copied unchanged. The report tells
+// where the blob ends in the new file and whether that is within the first
+// limit bytes.
+//
+struct FrontLoadOptions {
+    size_t limit = 4096;                // Report whether EXIF ends within this many bytes
+    bool keepOldExif = false;
+};
+
+struct FrontLoadReport {
+    size_t exifOffset = 0;              // Offset of the blob in the new file
+    size_t exifEnd = 0;
+    bool withinLimit = false;
+    size_t movedSegments = 0;           // Segments that now follow the blob
+    size_t droppedSegments = 0;         // Old EXIF segments
+    size_t fileSize = 0;                // Of the new file, set by writeFrontLoadedJpeg()
+};
+
+// Builds the new metadata part (replacing jpeg[0, layout.insertOffset))
+ExifResult<FrontLoadReport> buildFrontLoadedHeader(const uint8_t* jpeg, const JpegHeaderLayout& layout, const uint8_t* exifBlob, size_t exifSize,
+    std::vector<uint8_t>& header, const FrontLoadOptions& options = FrontLoadOptions());
+
+// Copies originalFile to newFile with a front-loaded header. Only the header
+// is parsed, the rest of the file is streamed.
+ExifResult<FrontLoadReport> writeFrontLoadedJpeg(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize,
+    const FrontLoadOptions& options = FrontLoadOptions());
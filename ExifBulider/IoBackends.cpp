@@ -0,0 +1,207 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "IoBackends.h"
+#include "JpegHeader.h"
+#include "MappedFile.h"
+#include "MicroExifProbes.h"
+
+namespace {
+
+ExifResult<size_t> injectMapped(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize) {
+	MicroExifWriteProbes probes;
+	MappedFile input;
+	auto opened = input.open(originalFile);
+	if (!opened) {
+		return opened;
+	}
+	auto marker = tryFindFFDBMarker(input.data(), input.size());
+	if (!marker) {
+		return marker;
+	}
+
+	FILE* output = fopen(newFile.c_str(), "wb");
+	if (!output) {
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
+	}
+	size_t pos = marker.value;
+	size_t rest = input.size() - pos;
+	probes.writeStart(input.size(), exifSize);
+	bool written = fwrite(input.data(), 1, pos, output) == pos
+		&& fwrite(exifBlob, 1, exifSize, output) == exifSize
+		&& fwrite(input.data() + pos, 1, rest, output) == rest;
+	written = (fclose(output) == 0) && written;
+	if (!written) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+	probes.done(newFile.c_str(), input.size() + exifSize);
+	return ExifResult<size_t>::success(input.size() + exifSize);
+}
+
+#ifdef __linux__
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+	while (size > 0) {
+		ssize_t n = write(fd, data, size);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+// Copies size bytes from in at offset to the current position of out
+bool copyRange(int in, int out, off_t offset, size_t size) {
+	bool kernelCopy = true;
+	std::vector<uint8_t> buffer;
+	while (size > 0) {
+		if (kernelCopy) {
+			ssize_t n = copy_file_range(in, &offset, out, nullptr, size, 0);
+			if (n > 0) {
+				size -= static_cast<size_t>(n);
+				continue;
+			}
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n == 0) {
+				return false;
+			}
+			// EXDEV, EINVAL, ENOSYS, EOPNOTSUPP: copy in user space
+			kernelCopy = false;
+			buffer.resize(256 * 1024);
+		}
+		ssize_t n = pread(in, buffer.data(), std::min(size, buffer.size()), offset);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0 || !writeAll(out, buffer.data(), static_cast<size_t>(n))) {
+			return false;
+		}
+		offset += n;
+		size -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+ExifResult<size_t> injectCopyRange(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize) {
+	MicroExifWriteProbes probes;
+	FILE* input = fopen(originalFile.c_str(), "rb");
+	if (!input) {
+		return ExifResult<size_t>::failure(ExifError::OpenFailed);
+	}
+	std::vector<uint8_t> header;
+	JpegHeaderLayout layout;
+	auto scanned = readJpegHeader(input, header, layout);
+	// The DQT marker lies in front of SOS, so the header is enough
+	auto marker = scanned ? tryFindFFDBMarker(header.data(), layout.headerSize) : ExifResult<size_t>::failure(scanned.error, scanned.offset);
+	struct stat info;
+	if (marker && fstat(fileno(input), &info) != 0) {
+		marker = ExifResult<size_t>::failure(ExifError::ReadFailed);
+	}
+	if (!marker) {
+		fclose(input);
+		return marker;
+	}
+
+	int output = open(newFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (output < 0) {
+		fclose(input);
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
+	}
+	size_t pos = marker.value;
+	size_t fileSize = static_cast<size_t>(info.st_size);
+	probes.writeStart(fileSize, exifSize);
+	bool written = writeAll(output, header.data(), pos)
+		&& writeAll(output, exifBlob, exifSize)
+		&& copyRange(fileno(input), output, static_cast<off_t>(pos), fileSize - pos);
+	written = (close(output) == 0) && written;
+	fclose(input);
+	if (!written) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+	probes.done(newFile.c_str(), fileSize + exifSize);
+	return ExifResult<size_t>::success(fileSize + exifSize);
+}
+
+#endif
+
+} // namespace
+
+const char* ioBackendName(IoBackend backend) {
+	switch (backend) {
+	case IoBackend::Stream: return "stream";
+	case IoBackend::Mmap: return "mmap";
+	case IoBackend::CopyRange: return "copy_file_range";
+	}
+	return "unknown";
+}
+
+bool parseIoBackend(const std::string& name, IoBackend& backend) {
+	for (size_t i = 0; i < ioBackendCount; ++i) {
+		if (name == ioBackendName(static_cast<IoBackend>(i))) {
+			backend = static_cast<IoBackend>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ioBackendAvailable(IoBackend backend) {
+#ifdef __linux__
+	(void)backend;
+	return true;
+#else
+	return backend != IoBackend::CopyRange;
+#endif
+}
+
+ExifResult<size_t> injectExifFile(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize, IoBackend backend) {
+	switch (backend) {
+	case IoBackend::Mmap:
+		return injectMapped(originalFile, newFile, exifBlob, exifSize);
+#ifdef __linux__
+	case IoBackend::CopyRange:
+		return injectCopyRange(originalFile, newFile, exifBlob, exifSize);
+#endif
+	default:
+		return tryWriteNewJpegWithExif(originalFile, newFile, exifBlob, exifSize);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// File injection backends:
+//
+// Three ways to copy a JPEG with the EXIF blob inserted in front of the
+// DQT marker (the same position as writeNewJpegWithExif()):
+//
+// - Stream:    read the whole file into memory and write it out with stdio.
+// - Mmap:      map the input and write the pieces straight from the mapping.
+// - CopyRange: read only the header, then let the kernel copy the rest with
+//              copy_file_range (Linux, may share extents on CoW file systems).
+//              Falls back to pread/write if the file system refuses.
+//
+// Which one is fastest depends on the volume; see StorageTuner.
+//
+enum class IoBackend : uint8_t {
+    Stream,
+    Mmap,
+    CopyRange
+};
+
+constexpr size_t ioBackendCount = 3;
+
+const char* ioBackendName(IoBackend backend);
+bool parseIoBackend(const std::string& name, IoBackend& backend);
+// False if the backend is not supported on this platform
+bool ioBackendAvailable(IoBackend backend);
+
+// The value of the result is the size of the new file. Unavailable backends
+// use Stream.
+ExifResult<size_t> injectExifFile(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize, IoBackend backend);
@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "JpegHeader.h"
+#include "MicroExifProbes.h"
+
+ExifResult<size_t> scanJpegHeader(const uint8_t* data, size_t size, JpegHeaderLayout& layout) {
+	if (layout.complete) {
+		return ExifResult<size_t>::success(layout.insertOffset);
+	}
+
+	size_t pos = layout.scanOffset;
+	if (pos == 0) {
+		if (size < 2) {
+			return ExifResult<size_t>::failure(ExifError::Truncated, 2);
+		}
+		if (data[0] != 0xFF || data[1] != 0xD8) {
+			return ExifResult<size_t>::failure(ExifError::NotJpeg, 0);
+		}
+		layout.segments.push_back({ 0xD8, 0, 2 });
+		pos = layout.scanOffset = 2;
+	}
+
+	for (;;) {
+		// A marker may be preceded by any number of 0xFF fill bytes
+		size_t markerPos = pos;
+		while (pos < size && data[pos] == 0xFF) {
+			++pos;
+		}
+		if (pos >= size) {
+			return ExifResult<size_t>::failure(ExifError::Truncated, pos + 1);
+		}
+		if (pos == markerPos || data[pos] == 0x00) {
+			return ExifResult<size_t>::failure(ExifError::Malformed, markerPos);
+		}
+		uint8_t marker = data[pos];
+		markerPos = pos - 1;
+		++pos;
+
+		// Standalone markers (TEM, RSTn) carry no length
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+			layout.segments.push_back({ marker, markerPos, 2 });
+			layout.scanOffset = pos;
+			continue;
+		}
+		if (marker == 0xD8 || marker == 0xD9) {
+			return ExifResult<size_t>::failure(ExifError::Malformed, markerPos);
+		}
+
+		if (pos + 2 > size) {
+			return ExifResult<size_t>::failure(ExifError::Truncated, pos + 2);
+		}
+		size_t length = (static_cast<size_t>(data[pos]) << 8) | data[pos + 1];
+		if (length < 2) {
+			return ExifResult<size_t>::failure(ExifError::Malformed, markerPos);
+		}
+		size_t end = pos + length;
+		if (end > size) {
+			return ExifResult<size_t>::failure(ExifError::Truncated, end);
+		}
+
+		bool appOrCom = (marker >= 0xE0 && marker <= 0xEF) || marker == 0xFE;
+		if (!appOrCom && layout.insertOffset == 0) {
+			layout.insertOffset = markerPos;
+		}
+		layout.segments.push_back({ marker, markerPos, end - markerPos });
+		layout.scanOffset = pos = end;
+
+		if (marker == 0xDA) {
+			layout.headerSize = end;
+			layout.complete = true;
+			MICROEXIF_PROBE3(segment__walk, layout.insertOffset, size, 1);
+			return ExifResult<size_t>::success(layout.insertOffset);
+		}
+	}
+}
+
+bool isJpegAppSegment(const uint8_t* data, const JpegSegment& segment, uint8_t marker, const char* identifier, size_t identifierSize) {
+	return segment.marker == marker
+		&& segment.length >= 4 + identifierSize
+		&& std::memcmp(data + segment.offset + 4, identifier, identifierSize) == 0;
+}
+
+ExifResult<size_t> readJpegHeader(FILE* file, std::vector<uint8_t>& buffer, JpegHeaderLayout& layout) {
+	layout.reset();
+	buffer.clear();
+
+	// Most headers fit into the first read, large APPn segments need a few more
+	size_t chunk = 16 * 1024;
+	for (;;) {
+		size_t filled = buffer.size();
+		buffer.resize(filled + chunk);
+		size_t read = fread(buffer.data() + filled, 1, chunk, file);
+		buffer.resize(filled + read);
+
+		auto scanned = scanJpegHeader(buffer.data(), buffer.size(), layout);
+		if (scanned || scanned.error != ExifError::Truncated) {
+			return scanned;
+		}
+		if (read < chunk) {
+			return ferror(file) ? ExifResult<size_t>::failure(ExifError::ReadFailed, buffer.size()) : scanned;
+		}
+		chunk = std::max(chunk * 2, scanned.offset - buffer.size());
+	}
+}
@@ -0,0 +1,85 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// JPEG header walker:
+//
+// Walks the marker segments of a JPEG from SOI up to and including SOS,
+// using the segment lengths instead of searching for marker bytes, so
+// markers inside APPn payloads (e.g. embedded thumbnails) are skipped.
+//
+// The walk can be resumed: scanJpegHeader() continues from layout.scanOffset,
+// so a streaming caller can call it again after more data arrived. It returns
+// ExifError::Truncated (offset = bytes needed so far) until the SOS segment
+// is complete.
+//
+struct JpegSegment {
+    uint8_t marker;     // Second marker byte, e.g. 0xE1 for APP1
+    size_t offset;      // Offset of the 0xFF marker byte
+    size_t length;      // Total size including the marker, 2 for SOI
+};
+
+struct JpegHeaderLayout {
+    std::vector<JpegSegment> segments;  // SOI ... SOS
+    size_t insertOffset = 0;            // In front of the first segment that is not SOI, APPn or COM
+    size_t headerSize = 0;              // Offset of the entropy-coded data after SOS
+    size_t scanOffset = 0;              // Where a resumed walk continues
+    bool complete = false;              // SOS has been reached
+
+    void reset() {
+        segments.clear();
+        insertOffset = headerSize = scanOffset = 0;
+        complete = false;
+    }
+
+    // First segment with the given marker, or nullptr
+    const JpegSegment* find(uint8_t marker) const {
+        for (const auto& segment : segments) {
+            if (segment.marker == marker) {
+                return &segment;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// The value of the result is layout.insertOffset
+ExifResult<size_t> scanJpegHeader(const uint8_t* data, size_t size, JpegHeaderLayout& layout);
+
+// True for an APPn segment whose payload starts with the given identifier,
+// e.g. isJpegAppSegment(data, segment, 0xE1, "Exif\0", 6)
+bool isJpegAppSegment(const uint8_t* data, const JpegSegment& segment, uint8_t marker, const char* identifier, size_t identifierSize);
+
+// Reads a JPEG file from its start until scanJpegHeader() has seen SOS, so
+// only the header is read and not the entropy-coded data. buffer holds at
+// least layout.headerSize bytes afterwards. The value of the result is
+// layout.insertOffset.
+ExifResult<size_t> readJpegHeader(FILE* file, std::vector<uint8_t>& buffer, JpegHeaderLayout& layout);
@@ -0,0 +1,80 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "JpegSpliceCache.h"
+
+ExifResult<const JpegHeaderLayout*> JpegSpliceCache::lookup(const uint8_t* data, size_t size) {
+	uint64_t key = exifHash64Words(data, std::min(size, keySize));
+	++useClock;
+
+	for (auto& entry : entries) {
+		if (entry.key == key && entry.header.size() <= size
+			&& std::memcmp(entry.header.data(), data, entry.header.size()) == 0) {
+			entry.lastUse = useClock;
+			++hitCount;
+			return ExifResult<const JpegHeaderLayout*>::success(&entry.layout);
+		}
+	}
+
+	++missCount;
+	scratch.reset();
+	auto scan = scanJpegHeader(data, size, scratch);
+	if (!scan) {
+		return ExifResult<const JpegHeaderLayout*>::failure(scan.error, scan.offset);
+	}
+
+	// Replace the least recently used entry once the cache is full
+	Entry* slot = nullptr;
+	if (entries.size() < capacity) {
+		entries.emplace_back();
+		slot = &entries.back();
+	}
+	else {
+		slot = &*std::min_element(entries.begin(), entries.end(),
+			[](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+	}
+	slot->key = key;
+	slot->header.assign(data, data + scratch.headerSize);
+	std::swap(slot->layout, scratch);
+	slot->lastUse = useClock;
+	return ExifResult<const JpegHeaderLayout*>::success(&slot->layout);
+}
+
+ExifResult<size_t> spliceExif(const uint8_t* jpeg, size_t jpegSize, const uint8_t* exifBlob, size_t exifSize,
+	std::vector<uint8_t>& out, JpegSpliceCache& cache) {
+	auto layout = cache.lookup(jpeg, jpegSize);
+	if (!layout) {
+		return ExifResult<size_t>::failure(layout.error, layout.offset);
+	}
+
+	size_t insertAt = layout.value->insertOffset;
+	out.resize(jpegSize + exifSize);
+	std::memcpy(out.data(), jpeg, insertAt);
+	std::memcpy(out.data() + insertAt, exifBlob, exifSize);
+	std::memcpy(out.data() + insertAt + exifSize, jpeg + insertAt, jpegSize - insertAt);
+	return ExifResult<size_t>::success(insertAt);
+}
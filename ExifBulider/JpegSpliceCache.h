@@ -0,0 +1,80 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "JpegHeader.h"
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// JpegSpliceCache:
+//
+// Frames from one encoder configuration share a byte-identical header
+// (SOI/APP0/DQT/DHT/SOF/SOS). The cache remembers the last few header
+// layouts, keyed by a hash of the first bytes of the file. For a new frame
+// the candidate header is verified with a single memcmp and its layout is
+// reused, so steady-state streams skip the segment walk entirely.
+//
+// A cache is not thread-safe, use one per worker or per stream.
+//
+class JpegSpliceCache {
+public:
+    explicit JpegSpliceCache(size_t capacity = 8) : capacity(capacity ? capacity : 1) {}
+
+    // Layout of the header of data, from the cache if possible. The pointer
+    // stays valid until the next call to lookup() or clear().
+    ExifResult<const JpegHeaderLayout*> lookup(const uint8_t* data, size_t size);
+
+    void clear() {
+        entries.clear();
+    }
+
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+
+private:
+    // Number of leading bytes that form the lookup key
+    static constexpr size_t keySize = 64;
+
+    struct Entry {
+        uint64_t key;
+        std::vector<uint8_t> header;    // SOI ... end of SOS
+        JpegHeaderLayout layout;
+        uint64_t lastUse;
+    };
+
+    size_t capacity;
+    std::vector<Entry> entries;
+    JpegHeaderLayout scratch;
+    uint64_t useClock = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
+
+// Writes jpeg with the EXIF blob at the cached insertion point into out,
+// reusing its capacity. The value of the result is the insertion offset.
+ExifResult<size_t> spliceExif(const uint8_t* jpeg, size_t jpegSize, const uint8_t* exifBlob, size_t exifSize,
+    std::vector<uint8_t>& out, JpegSpliceCache& cache);
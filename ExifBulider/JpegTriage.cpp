@@ -0,0 +1,151 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "JpegHeader.h"
+#include "JpegTriage.h"
+
+#ifdef _WIN32
+#define microexif_fseek _fseeki64
+#define microexif_ftell _ftelli64
+#else
+#define microexif_fseek fseeko
+#define microexif_ftell ftello
+#endif
+
+namespace {
+
+constexpr size_t tailSize = 64;
+
+bool isProgressiveFrame(uint8_t marker) {
+	return marker == 0xC2 || marker == 0xC6 || marker == 0xCA || marker == 0xCE;
+}
+
+// EOI at the end of data, optionally followed by zero padding
+bool endsWithEoi(const uint8_t* data, size_t size) {
+	while (size > 0 && data[size - 1] == 0x00) {
+		--size;
+	}
+	return size >= 2 && data[size - 2] == 0xFF && data[size - 1] == 0xD9;
+}
+
+} // namespace
+
+void TriageSummary::add(const JpegTriage& triage) {
+	++files;
+	++status[static_cast<size_t>(triage.status)];
+	progressive += triage.progressive ? 1 : 0;
+	exif += triage.hasExif ? 1 : 0;
+	icc += triage.hasIcc ? 1 : 0;
+	bytesRead += triage.bytesRead;
+}
+
+JpegTriage triageJpegFile(const std::string& path) {
+	JpegTriage triage;
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		triage.status = ExifError::OpenFailed;
+		return triage;
+	}
+	if (microexif_fseek(file, 0, SEEK_END) != 0 || microexif_ftell(file) < 0) {
+		fclose(file);
+		triage.status = ExifError::ReadFailed;
+		return triage;
+	}
+	triage.fileSize = static_cast<uint64_t>(microexif_ftell(file));
+	microexif_fseek(file, 0, SEEK_SET);
+
+	std::vector<uint8_t> buffer;
+	JpegHeaderLayout layout;
+	auto scanned = readJpegHeader(file, buffer, layout);
+	triage.bytesRead = buffer.size();
+	for (const auto& segment : layout.segments) {
+		triage.progressive = triage.progressive || isProgressiveFrame(segment.marker);
+		triage.hasExif = triage.hasExif || isJpegAppSegment(buffer.data(), segment, 0xE1, "Exif\0", 6);
+		triage.hasIcc = triage.hasIcc || isJpegAppSegment(buffer.data(), segment, 0xE2, "ICC_PROFILE", 12);
+	}
+	if (!scanned) {
+		fclose(file);
+		triage.status = scanned.error;
+		return triage;
+	}
+	if (layout.headerSize >= triage.fileSize) {
+		fclose(file);
+		triage.status = ExifError::Truncated;
+		return triage;
+	}
+
+	// Small files are already read completely
+	if (buffer.size() < triage.fileSize) {
+		size_t tail = static_cast<size_t>(std::min<uint64_t>(tailSize, triage.fileSize - layout.headerSize));
+		buffer.resize(tail);
+		bool read = microexif_fseek(file, -static_cast<long long>(tail), SEEK_END) == 0 && fread(buffer.data(), 1, tail, file) == tail;
+		triage.bytesRead += tail;
+		if (!read) {
+			fclose(file);
+			triage.status = ExifError::ReadFailed;
+			return triage;
+		}
+	}
+	fclose(file);
+	triage.status = endsWithEoi(buffer.data(), buffer.size()) ? ExifError::None : ExifError::Truncated;
+	return triage;
+}
+
+const char* triageStatusName(ExifError status) {
+	switch (status) {
+	case ExifError::None:
+		return "ok";
+	case ExifError::Truncated:
+		return "truncated";
+	case ExifError::NotJpeg:
+		return "not-jpeg";
+	case ExifError::OpenFailed:
+	case ExifError::ReadFailed:
+		return "unreadable";
+	default:
+		return "malformed";
+	}
+}
+
+TriageSummary triageDirectory(const std::string& root, const CrawlOptions& options, const TriageSink& sink, CrawlStats* crawlStats) {
+	TriageSummary summary;
+	std::mutex mutex;
+	CrawlStats stats = crawlDirectory(root, options, [&](std::string&& path) {
+		JpegTriage triage = triageJpegFile(path);
+		if (sink) {
+			sink(path, triage);
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		summary.add(triage);
+	});
+	if (crawlStats) {
+		*crawlStats = stats;
+	}
+	return summary;
+}
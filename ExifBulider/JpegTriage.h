@@ -0,0 +1,79 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "FileCrawler.h"
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// JPEG triage:
+//
+// Pre-flight check for archives: classifies a file with two small reads
+// instead of reading it completely. The header is walked from SOI to SOS
+// with readJpegHeader(), and the last bytes of the file are read to check
+// for the EOI marker (zero padding after it is accepted). A file that has
+// no entropy-coded data left after its header, or whose tail does not end
+// in EOI, is reported as truncated.
+//
+// The status is an ExifError: None for a complete JPEG, Truncated,
+// NotJpeg, Malformed (broken segment structure), or OpenFailed/ReadFailed.
+// Progressive coding and EXIF/ICC segments are reported as flags, since
+// they combine with each other.
+//
+struct JpegTriage {
+    ExifError status = ExifError::None;
+    bool progressive = false;           // SOF2 (or another progressive SOF)
+    bool hasExif = false;
+    bool hasIcc = false;
+    uint64_t fileSize = 0;
+    size_t bytesRead = 0;
+};
+
+struct TriageSummary {
+    size_t files = 0;
+    size_t status[exifErrorCount] = {};     // Files by status, status[0] = ok
+    size_t progressive = 0;
+    size_t exif = 0;
+    size_t icc = 0;
+    uint64_t bytesRead = 0;
+
+    void add(const JpegTriage& triage);
+};
+
+JpegTriage triageJpegFile(const std::string& path);
+
+// Short label for reports: ok, truncated, not-jpeg, malformed, unreadable
+const char* triageStatusName(ExifError status);
+
+// Called concurrently for every file, may be empty
+using TriageSink = std::function<void(const std::string& path, const JpegTriage& triage)>;
+
+// Triages every file below root that the crawl matches. The files are
+// checked on the crawler threads as they are found.
+TriageSummary triageDirectory(const std::string& root, const CrawlOptions& options, const TriageSink& sink = TriageSink(),
+    CrawlStats* crawlStats = nullptr);
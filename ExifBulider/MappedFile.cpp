@@ -0,0 +1,108 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+ExifResult<size_t> MappedFile::open(const std::string& filename) {
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return ExifResult<size_t>::failure(ExifError::OpenFailed);
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return ExifResult<size_t>::failure(ExifError::ReadFailed);
+	}
+	if (size.QuadPart > 0) {
+		HANDLE view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* address = view ? MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!address) {
+			if (view) {
+				CloseHandle(view);
+			}
+			CloseHandle(file);
+			return ExifResult<size_t>::failure(ExifError::ReadFailed);
+		}
+		mapping = view;
+		mapped = static_cast<const uint8_t*>(address);
+	}
+	CloseHandle(file);
+	mappedSize = static_cast<size_t>(size.QuadPart);
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return ExifResult<size_t>::failure(ExifError::OpenFailed);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return ExifResult<size_t>::failure(ExifError::ReadFailed);
+	}
+	if (info.st_size > 0) {
+		void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (address == MAP_FAILED) {
+			::close(fd);
+			return ExifResult<size_t>::failure(ExifError::ReadFailed);
+		}
+		mapped = static_cast<const uint8_t*>(address);
+	}
+	::close(fd);
+	mappedSize = static_cast<size_t>(info.st_size);
+#endif
+
+	opened = true;
+	return ExifResult<size_t>::success(mappedSize);
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (mapped) {
+		UnmapViewOfFile(mapped);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+		mapping = nullptr;
+	}
+#else
+	if (mapped) {
+		munmap(const_cast<uint8_t*>(mapped), mappedSize);
+	}
+#endif
+	mapped = nullptr;
+	mappedSize = 0;
+	opened = false;
+}
@@ -22,74 +22,193 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <charconv>
+#include <chrono>
+#include <climits>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "BatchTagger.h"
+#include "Benchmark.h"
+#include "JpegTriage.h"
 #include "MicroExif.h"
+#include "MicroExifProbes.h"
+#include "SelfTest.h"
+#include "StorageTuner.h"
+
+#ifdef _WIN32
+#define microexif_fseek _fseeki64
+#define microexif_ftell _ftelli64
+#else
+#define microexif_fseek fseeko
+#define microexif_ftell ftello
+#endif
+
+const char* exifErrorString(ExifError error) {
+	switch (error) {
+	case ExifError::None: return "No error.";
+	case ExifError::OpenFailed: return "Unable to open file.";
+	case ExifError::ReadFailed: return "Error reading file.";
+	case ExifError::CreateFailed: return "Unable to create output file.";
+	case ExifError::WriteFailed: return "Error writing output file.";
+	case ExifError::NotJpeg: return "Not a JPEG file.";
+	case ExifError::Truncated: return "JPEG data is truncated.";
+	case ExifError::MarkerNotFound: return "FFDB marker not found.";
+	case ExifError::TooLarge: return "EXIF data exceeds the APP1 segment size.";
+	case ExifError::Malformed: return "Malformed JPEG segment.";
+	case ExifError::Mismatch: return "Data differs from the expected values.";
+	}
+	return "Unknown error.";
+}
 
-// Function to read a JPEG file into a dynamically allocated array
-uint8_t* readJpegFile(const std::string& filename, size_t& fileSize) {
-	std::ifstream file(filename, std::ios::binary | std::ios::ate);
-	if (!file.is_open()) {
-		throw std::runtime_error("Unable to open file.");
+// Function to read a JPEG file into a dynamically allocated array, without throwing
+ExifResult<uint8_t*> tryReadJpegFile(const std::string& filename, size_t& fileSize) {
+	fileSize = 0;
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (!file) {
+		return ExifResult<uint8_t*>::failure(ExifError::OpenFailed);
 	}
 
-	fileSize = file.tellg();
-	file.seekg(0, std::ios::beg);
+	if (microexif_fseek(file, 0, SEEK_END) != 0) {
+		fclose(file);
+		return ExifResult<uint8_t*>::failure(ExifError::ReadFailed);
+	}
+	auto size = microexif_ftell(file);
+	if (size < 0 || microexif_fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return ExifResult<uint8_t*>::failure(ExifError::ReadFailed);
+	}
 
-	uint8_t* buffer = new uint8_t[fileSize];
-	if (!file.read(reinterpret_cast<char*>(buffer), fileSize)) {
+	uint8_t* buffer = new (std::nothrow) uint8_t[static_cast<size_t>(size)];
+	if (!buffer) {
+		fclose(file);
+		return ExifResult<uint8_t*>::failure(ExifError::ReadFailed);
+	}
+	size_t bytesRead = fread(buffer, 1, static_cast<size_t>(size), file);
+	fclose(file);
+	if (bytesRead != static_cast<size_t>(size)) {
 		delete[] buffer;
-		throw std::runtime_error("Error reading file.");
+		return ExifResult<uint8_t*>::failure(ExifError::ReadFailed, bytesRead);
 	}
 
-	return buffer;
+	fileSize = bytesRead;
+	return ExifResult<uint8_t*>::success(buffer);
 }
 
-// Function to find the FFDB marker (0xFFDB)
-size_t findFFDBMarker(const uint8_t* jpegData, size_t fileSize) {
-	for (size_t i = 0; i < fileSize - 1; ++i) {
+// Function to find the FFDB marker (0xFFDB), without throwing
+ExifResult<size_t> tryFindFFDBMarker(const uint8_t* jpegData, size_t fileSize) {
+	if (fileSize < 2) {
+		return ExifResult<size_t>::failure(ExifError::Truncated, fileSize);
+	}
+	if (jpegData[0] != 0xFF || jpegData[1] != 0xD8) {
+		return ExifResult<size_t>::failure(ExifError::NotJpeg, 0);
+	}
+	for (size_t i = 2; i < fileSize - 1; ++i) {
 		if (jpegData[i] == 0xFF && jpegData[i + 1] == 0xDB) {
-			return i;
+			MICROEXIF_PROBE3(segment__walk, i, fileSize, 1);
+			return ExifResult<size_t>::success(i);
 		}
 	}
-	throw std::runtime_error("FFDB marker not found.");
+	MICROEXIF_PROBE3(segment__walk, fileSize, fileSize, 0);
+	return ExifResult<size_t>::failure(ExifError::MarkerNotFound, fileSize);
 }
 
-// Function to write the new JPEG file with the injected EXIF data
-void writeNewJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize) {
+// Function to write the new JPEG file with the injected EXIF data, without throwing.
+// The value of the result is the number of bytes written.
+ExifResult<size_t> tryWriteNewJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize) {
+	uint64_t startNs = MICROEXIF_PROBE_ENABLED(file__done) ? microexifProbeClockNs() : 0;
+
 	size_t fileSize = 0;
-	uint8_t* jpegData = readJpegFile(originalFile, fileSize);
+	auto jpegData = tryReadJpegFile(originalFile, fileSize);
+	if (!jpegData) {
+		return ExifResult<size_t>::failure(jpegData.error, jpegData.offset);
+	}
+	std::unique_ptr<uint8_t[]> data(jpegData.value);
 
 	// Find the position of the FFDB marker
-	size_t ffdBMarkerPos = findFFDBMarker(jpegData, fileSize);
+	auto ffdBMarkerPos = tryFindFFDBMarker(data.get(), fileSize);
+	if (!ffdBMarkerPos) {
+		return ffdBMarkerPos;
+	}
 
 	// Create and write to the new file
-	std::ofstream outputFile(newFile, std::ios::binary);
-	if (!outputFile.is_open()) {
-		delete[] jpegData;
-		throw std::runtime_error("Unable to create output file.");
+	FILE* outputFile = fopen(newFile.c_str(), "wb");
+	if (!outputFile) {
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
 	}
 
-	// Write bytes from the start of the file to the FFDB marker position
-	outputFile.write(reinterpret_cast<const char*>(jpegData), ffdBMarkerPos);
+	MICROEXIF_PROBE2(write__start, fileSize, exifSize);
+	uint64_t writeStartNs = MICROEXIF_PROBE_ENABLED(write__end) ? microexifProbeClockNs() : 0;
+
+	size_t pos = ffdBMarkerPos.value;
+	bool written =
+		// Write bytes from the start of the file to the FFDB marker position
+		fwrite(data.get(), 1, pos, outputFile) == pos &&
+		// Write the EXIF blob
+		fwrite(exifBlob, 1, exifSize, outputFile) == exifSize &&
+		// Write the rest of the original JPEG file starting from the FFDB marker
+		fwrite(data.get() + pos, 1, fileSize - pos, outputFile) == fileSize - pos;
+	written = (fclose(outputFile) == 0) && written;
+	if (!written) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
 
-	// Write the EXIF blob
-	outputFile.write(reinterpret_cast<const char*>(exifBlob), exifSize);
+	if (writeStartNs != 0) {
+		MICROEXIF_PROBE2(write__end, fileSize + exifSize, microexifProbeClockNs() - writeStartNs);
+	}
+	if (startNs != 0) {
+		MICROEXIF_PROBE3(file__done, newFile.c_str(), fileSize + exifSize, microexifProbeClockNs() - startNs);
+	}
+	return ExifResult<size_t>::success(fileSize + exifSize);
+}
 
-	// Write the rest of the original JPEG file starting from the FFDB marker
-	outputFile.write(reinterpret_cast<const char*>(jpegData + ffdBMarkerPos), fileSize - ffdBMarkerPos);
+// Function to read a JPEG file into a dynamically allocated array
+uint8_t* readJpegFile(const std::string& filename, size_t& fileSize) {
+	auto result = tryReadJpegFile(filename, fileSize);
+	if (!result) {
+		throw std::runtime_error(exifErrorString(result.error));
+	}
+	return result.value;
+}
 
-	outputFile.close();
-	delete[] jpegData;
+// Function to find the FFDB marker (0xFFDB)
+size_t findFFDBMarker(const uint8_t* jpegData, size_t fileSize) {
+	auto result = tryFindFFDBMarker(jpegData, fileSize);
+	if (!result) {
+		throw std::runtime_error(exifErrorString(result.error));
+	}
+	return result.value;
+}
+
+// Function to write the new JPEG file with the injected EXIF data
+void writeNewJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize) {
+	auto result = tryWriteNewJpegWithExif(originalFile, newFile, exifBlob, exifSize);
+	if (!result) {
+		throw std::runtime_error(exifErrorString(result.error));
+	}
+}
+
+// Function to parse a non-negative decimal flag value, rejecting signs, trailing text and overflow
+static bool parseUnsignedFlag(const char* text, unsigned& value) {
+	const char* end = text + strlen(text);
+	unsigned long parsed = 0;
+	auto result = std::from_chars(text, end, parsed);
+	if (result.ec != std::errc() || result.ptr != end || parsed > UINT_MAX) {
+		return false;
+	}
+	value = static_cast<unsigned>(parsed);
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -97,9 +216,81 @@ int main(int argc, char* argv[]) {
 
 	if (argc < 2) {
 		std::cerr << "Usage: " << argv[0] << " <JPEG file>" << std::endl;
+		std::cerr << "       " << argv[0] << " --bench [--perf] [--time <ms>] [--filter <name>] [JPEG file]" << std::endl;
+		std::cerr << "       " << argv[0] << " --batch <input dir> <output dir> [--threads <n>] [--magic] [--placement <spec>] [--backend <name>] [--adaptive] [--autotune <cache file>] [--front-load <KB>] [--durable <window ms>] [--normalize <MM|II>]" << std::endl;
+		std::cerr << "       " << argv[0] << " --triage <dir> [--threads <n>] [--magic] [--list <file>]" << std::endl;
+		std::cerr << "       " << argv[0] << " --selftest [scratch dir]" << std::endl;
 		return 1;
 	}
 
+	if (std::string(argv[1]) == "--bench") {
+		return benchmarkMain(argc - 2, argv + 2);
+	}
+
+	if (std::string(argv[1]) == "--selftest") {
+		return selfTestMain(argc - 2, argv + 2);
+	}
+
+	if (std::string(argv[1]) == "--triage") {
+		if (argc < 3) {
+			std::cerr << "Usage: " << argv[0] << " --triage <dir> [--threads <n>] [--magic] [--list <file>]" << std::endl;
+			return 1;
+		}
+		CrawlOptions crawlOptions;
+		std::string listFile;
+		for (int arg = 3; arg < argc; ++arg) {
+			std::string flag = argv[arg];
+			if (flag == "--threads" && arg + 1 < argc) {
+				if (!parseUnsignedFlag(argv[++arg], crawlOptions.threads)) {
+					std::cerr << "Invalid thread count: " << argv[arg] << std::endl;
+					return 1;
+				}
+			}
+			else if (flag == "--magic") {
+				crawlOptions.checkMagic = true;
+			}
+			else if (flag == "--list" && arg + 1 < argc) {
+				listFile = argv[++arg];
+			}
+		}
+
+		// One line per file: status, flags, path
+		std::ofstream list;
+		std::mutex listMutex;
+		if (!listFile.empty()) {
+			list.open(listFile);
+			if (!list) {
+				std::cerr << "Cannot create " << listFile << std::endl;
+				return 1;
+			}
+		}
+		TriageSink sink;
+		if (list.is_open()) {
+			sink = [&](const std::string& path, const JpegTriage& triage) {
+				std::string flags = triage.progressive ? "progressive" : "baseline";
+				flags += triage.hasExif ? ",exif" : "";
+				flags += triage.hasIcc ? ",icc" : "";
+				std::lock_guard<std::mutex> lock(listMutex);
+				list << triageStatusName(triage.status) << '\t' << flags << '\t' << path << '\n';
+			};
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		CrawlStats crawl;
+		TriageSummary summary = triageDirectory(argv[2], crawlOptions, sink, &crawl);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%zu files checked in %.2f s, %.1f KB read per file\n", summary.files, seconds,
+			summary.files ? static_cast<double>(summary.bytesRead) / summary.files / 1024.0 : 0.0);
+		printf("  %zu ok\n", summary.status[0]);
+		for (size_t error = 1; error < exifErrorCount; ++error) {
+			if (summary.status[error] != 0) {
+				printf("  %zu x %s\n", summary.status[error], exifErrorString(static_cast<ExifError>(error)));
+			}
+		}
+		printf("%zu progressive, %zu with EXIF, %zu with ICC profile\n", summary.progressive, summary.exif, summary.icc);
+		return summary.status[0] == summary.files && crawl.errors == 0 ? 0 : 1;
+	}
+
 
 	ExifBuilder builder;
 
@@ -143,6 +334,122 @@ int main(int argc, char* argv[]) {
 	// Build EXIF blob
 	std::vector<uint8_t> exifBlob = builder.buildExifBlob();
 
+	if (std::string(argv[1]) == "--batch") {
+		if (argc < 4) {
+			std::cerr << "Usage: " << argv[0] << " --batch <input dir> <output dir> [--threads <n>] [--magic] [--placement <spec>] [--backend <name>] [--adaptive] [--autotune <cache file>] [--front-load <KB>] [--durable <window ms>] [--normalize <MM|II>]" << std::endl;
+			return 1;
+		}
+		if (batchRootsOverlap(argv[2], argv[3])) {
+			std::cerr << "Input and output directory must not overlap: " << argv[2] << ", " << argv[3] << std::endl;
+			return 1;
+		}
+		BatchOptions options;
+		CrawlOptions crawlOptions;
+		std::string tuneCache;
+		std::unique_ptr<DurableWriter> durable;
+		for (int arg = 4; arg < argc; ++arg) {
+			std::string flag = argv[arg];
+			if (flag == "--threads" && arg + 1 < argc) {
+				if (!parseUnsignedFlag(argv[++arg], options.workers)) {
+					std::cerr << "Invalid thread count: " << argv[arg] << std::endl;
+					return 1;
+				}
+			}
+			else if (flag == "--magic") {
+				crawlOptions.checkMagic = true;
+			}
+			else if (flag == "--backend" && arg + 1 < argc) {
+				if (!parseIoBackend(argv[++arg], options.backend)) {
+					std::cerr << "Unknown backend: " << argv[arg] << " (stream, mmap or copy_file_range)" << std::endl;
+					return 1;
+				}
+			}
+			else if (flag == "--front-load" && arg + 1 < argc) {
+				unsigned limitKB = 0;
+				if (!parseUnsignedFlag(argv[++arg], limitKB) || limitKB > SIZE_MAX / 1024) {
+					std::cerr << "Invalid front-load limit: " << argv[arg] << " (KB)" << std::endl;
+					return 1;
+				}
+				options.frontLoad = true;
+				options.frontLoadOptions.limit = static_cast<size_t>(limitKB) * 1024;
+			}
+			else if (flag == "--durable" && arg + 1 < argc) {
+				DurableOptions durableOptions;
+				if (!parseUnsignedFlag(argv[++arg], durableOptions.commitWindowMs)) {
+					std::cerr << "Invalid commit window: " << argv[arg] << " (ms)" << std::endl;
+					return 1;
+				}
+				durable = std::make_unique<DurableWriter>(durableOptions);
+				options.durable = durable.get();
+			}
+			else if (flag == "--normalize" && arg + 1 < argc) {
+				std::string order = argv[++arg];
+				if (order != "MM" && order != "II") {
+					std::cerr << "Unknown byte order: " << order << " (MM or II)" << std::endl;
+					return 1;
+				}
+				options.byteOrder = order == "MM" ? ExifByteOrder::BigEndian : ExifByteOrder::LittleEndian;
+			}
+			else if (flag == "--adaptive") {
+				options.adaptive = true;
+			}
+			else if (flag == "--autotune" && arg + 1 < argc) {
+				tuneCache = argv[++arg];
+			}
+			else if (flag == "--placement" && arg + 1 < argc) {
+				if (!ThreadPlacement::parse(argv[++arg], options.placement)) {
+					std::cerr << "Invalid placement: " << argv[arg] << " (none, node:N, spread or cpus:list)" << std::endl;
+					return 1;
+				}
+				crawlOptions.placement = options.placement;
+			}
+		}
+
+		if (!tuneCache.empty()) {
+			// A few input files are enough to probe the output volume
+			std::vector<std::string> samples;
+			std::mutex samplesMutex;
+			CrawlOptions sampleOptions = crawlOptions;
+			sampleOptions.maxFiles = 32;
+			crawlDirectory(argv[2], sampleOptions, [&](std::string&& path) {
+				std::lock_guard<std::mutex> lock(samplesMutex);
+				samples.push_back(std::move(path));
+			});
+			StorageTuner tuner(tuneCache);
+			StorageProfile profile = tuner.profileFor(argv[3], samples, exifBlob.data(), exifBlob.size());
+			options.backend = profile.backend;
+			options.workers = profile.workers;
+			options.adaptive = true;
+			printf("Storage profile: %s, %u workers (%.0f files/s in calibration)\n", ioBackendName(profile.backend), profile.workers, profile.filesPerSecond);
+		}
+
+		BatchRunStats run = tagDirectory(argv[2], argv[3], exifBlob.data(), exifBlob.size(), options, crawlOptions);
+		printf("%zu directories, %zu files found, %zu tagged, %zu failed in %.2f s (%u workers active at the end)\n",
+			run.crawl.directories, run.crawl.matched, run.batch.tagged, run.batch.failed, run.seconds, run.batch.activeWorkers);
+		if (options.frontLoad) {
+			printf("EXIF ends within the first %zu KB in %zu of %zu files\n", options.frontLoadOptions.limit / 1024,
+				run.batch.tagged - run.batch.exifBeyondLimit, run.batch.tagged);
+		}
+		if (options.byteOrder != ExifByteOrder::Keep) {
+			printf("EXIF byte order converted in %zu of %zu files\n", run.batch.converted, run.batch.tagged);
+		}
+		if (durable) {
+			DurableWriter::Stats durableStats = durable->stats();
+			printf("Durable output: %zu files published in %zu commits with %zu syncs, %zu failed\n", durableStats.files, durableStats.commits,
+				durableStats.syncs, durableStats.failed);
+		}
+		if (run.numaAvailable) {
+			printf("NUMA pages: %llu local, %llu remote, %llu miss\n", static_cast<unsigned long long>(run.numa.localNode),
+				static_cast<unsigned long long>(run.numa.remote()), static_cast<unsigned long long>(run.numa.miss));
+		}
+		for (size_t error = 1; error < exifErrorCount; ++error) {
+			if (run.batch.errors[error] != 0) {
+				printf("  %zu x %s\n", run.batch.errors[error], exifErrorString(static_cast<ExifError>(error)));
+			}
+		}
+		return run.batch.failed == 0 && run.crawl.errors == 0 ? 0 : 1;
+	}
+
 	// Output EXIF blob for debugging
 	size_t i = 0;
 	for (auto byte : exifBlob) {
@@ -25,9 +25,13 @@ SOFTWARE.
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 #include <variant>
 
+#include "MicroExifProbes.h"
+
 ////////////////////////////////////////////////////////////////////////////////////
 // ExifTag structure:
 // 
@@ -92,154 +96,368 @@ struct ExifTag {
     }
 };
 
+// 64-bit FNV-1a hash, used for cache keys and content checks (pass the
+// previous result as seed to hash several pieces)
+inline uint64_t exifHash64(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Faster variant for cache keys: mixes a word at a time, so the result
+// differs from exifHash64() for the same bytes
+inline uint64_t exifHash64Words(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = 0xcbf29ce484222325ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    return exifHash64(bytes + i, size - i, hash);
+}
+
 // ExifBuilder class
 class ExifBuilder {
 private:
     std::vector<ExifTag> tags;          // List of EXIF tags
-    std::vector<uint8_t> extraData;     // Buffer for extra data (strings, RATIONALs, etc.)
 
 public:
+    // Size of the APP1 marker, length field and "Exif\0\0" in front of the TIFF header
+    static constexpr size_t app1HeaderSize = 10;
+
     void addTag(ExifTag&& tag) {
         tags.push_back(std::move(tag));
     }
 
-    std::vector<uint8_t> buildExifBlob() {
-        std::vector<uint8_t> exifBlob;
-        
+    // Replaces the tag with the same ID, or adds it if there is none
+    void setTag(ExifTag&& tag) {
+        for (auto& existing : tags) {
+            if (existing.tag == tag.tag) {
+                existing = std::move(tag);
+                return;
+            }
+        }
+        tags.push_back(std::move(tag));
+    }
+
+    // Like setTag(), but reuses the storage of an existing tag, so updating
+    // a value of the same or smaller size does not allocate.
+    // data holds count values of the given type in host byte order.
+    void setTagValue(uint16_t tag, uint16_t type, uint32_t count, const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        ExifTag* existing = findTag(tag);
+        if (!existing) {
+            tags.push_back(ExifTag(tag, type, count, uint8_t(0)));
+            existing = &tags.back();
+        }
+        existing->type = type;
+        existing->count = count;
+        existing->value.assign(bytes, bytes + size);
+    }
+
+    // ASCII variant of setTagValue(), text does not need to be null-terminated
+    void setTagString(uint16_t tag, const char* text, size_t length) {
+        setTagValue(tag, 0x0002, static_cast<uint32_t>(length + 1), text, length);
+        findTag(tag)->value.push_back('\0'); // Null-terminate the string
+    }
+
+    ExifTag* findTag(uint16_t tag) {
+        for (auto& existing : tags) {
+            if (existing.tag == tag) {
+                return &existing;
+            }
+        }
+        return nullptr;
+    }
+
+    bool removeTag(uint16_t tag) {
+        for (auto it = tags.begin(); it != tags.end(); ++it) {
+            if (it->tag == tag) {
+                tags.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        tags.clear();
+    }
+
+    const std::vector<ExifTag>& getTags() const {
+        return tags;
+    }
+
+    // Size of the complete APP1 segment returned by buildExifBlob()
+    size_t exifBlobSize() const {
+        return app1HeaderSize + 8 + ifdSize(tags);
+    }
+
+    // Serializes the APP1 segment into a caller-owned buffer without allocating.
+    // Returns the number of bytes written, or 0 if the buffer is too small or
+    // the tags do not fit into a single APP1 segment (64 KB).
+    size_t buildExifBlobInto(uint8_t* dst, size_t capacity) const {
+        MICROEXIF_PROBE1(build__start, tags.size());
+        uint64_t startNs = MICROEXIF_PROBE_ENABLED(build__end) ? microexifProbeClockNs() : 0;
+
+        size_t blobSize = exifBlobSize();
+        if (blobSize > capacity || blobSize - 2 > 0xFFFF) {
+            return 0;
+        }
+
         bool bigendian = true;
 
-        // Placeholder for APP1 header (to be filled in later)
-        exifBlob.insert(exifBlob.end(), { 0xFF, 0xE1, 0x00, 0x00 });            // APP1 marker, length placeholder
-        exifBlob.insert(exifBlob.end(), { 'E', 'x', 'i', 'f', 0x00, 0x00 });    // "Exif" identifier and padding
+        // APP1 header, the length excludes the APP1 marker (FF E1)
+        const uint8_t app1[app1HeaderSize] = { 0xFF, 0xE1, 0x00, 0x00, 'E', 'x', 'i', 'f', 0x00, 0x00 };
+        std::memcpy(dst, app1, app1HeaderSize);
+        putUInt16(dst + 2, static_cast<uint16_t>(blobSize - 2), true);
 
         // Write TIFF Header
-        appendUInt16(exifBlob, bigendian ? 0x4D4D : 0x4949);    // Big-endian indicator
-        appendUInt16(exifBlob, 0x002A, bigendian);              // TIFF version
-        appendUInt32(exifBlob, 0x00000008, bigendian);          // Offset to the first IFD
+        uint8_t* tiff = dst + app1HeaderSize;
+        putUInt16(tiff, bigendian ? 0x4D4D : 0x4949, true);     // Byte order indicator
+        putUInt16(tiff + 2, 0x002A, bigendian);                 // TIFF version
+        putUInt32(tiff + 4, 0x00000008, bigendian);             // Offset to the first IFD
+
+        writeIfd(tiff, 8, tags, 0, bigendian);
+
+        if (startNs != 0) {
+            MICROEXIF_PROBE3(build__end, tags.size(), blobSize, microexifProbeClockNs() - startNs);
+        }
+        return blobSize;
+    }
+
+    // Position of a tag value inside the blob built by buildExifBlobInto(), so
+    // prebuilt blobs can be patched in place. Returns false if the tag is not set.
+    bool tagValueLocation(uint16_t tag, size_t& offset, size_t& size) const {
+        size_t dataOffset = app1HeaderSize + 8 + 2 + tags.size() * 12 + 4;
+        for (size_t i = 0; i < tags.size(); ++i) {
+            bool inField = tagFitsInField(tags[i]);
+            if (tags[i].tag == tag) {
+                offset = inField ? app1HeaderSize + 8 + 2 + i * 12 + 8 : dataOffset;
+                size = tags[i].value.size();
+                return true;
+            }
+            if (!inField) {
+                dataOffset += tags[i].value.size() + (tags[i].value.size() % 2);
+            }
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> buildExifBlob() const {
+        std::vector<uint8_t> exifBlob(exifBlobSize());
+        if (buildExifBlobInto(exifBlob.data(), exifBlob.size()) == 0) {
+            throw std::runtime_error("EXIF data exceeds the APP1 segment size.");
+        }
+        return exifBlob;
+    }
 
-        // Number of directory entries
-        appendUInt16(exifBlob, static_cast<uint16_t>(tags.size()), bigendian);
+    ////////////////////////////////////////////////////////////////////////////////////
+    // IFD layout:
+    //
+    // An IFD is written as the entry count, 12-byte entries, the next IFD offset
+    // and then the values that do not fit into the 4-byte entry field, each one
+    // padded to an even size. All offsets are relative to the TIFF header.
+    //
 
-        // Calculate data offset (just after IFD entries and next IFD offset)
-        size_t dataOffset = 8 + 2 + (tags.size() * 12) + 4;
+    // Size of an IFD including its out-of-line values
+    static size_t ifdSize(const std::vector<ExifTag>& ifdTags) {
+        size_t size = 2 + ifdTags.size() * 12 + 4;
+        for (const auto& tag : ifdTags) {
+            if (!tagFitsInField(tag)) {
+                size += tag.value.size() + (tag.value.size() % 2);
+            }
+        }
+        return size;
+    }
+
+    // Writes an IFD at tiff + ifdOffset, the buffer must hold ifdSize() bytes there
+    static void writeIfd(uint8_t* tiff, uint32_t ifdOffset, const std::vector<ExifTag>& ifdTags, uint32_t nextIfdOffset, bool bigendian) {
+        writeIfdAt(tiff + ifdOffset, ifdOffset, ifdTags, nextIfdOffset, bigendian);
+    }
+
+    // Writes an IFD into a buffer of ifdSize() bytes that will be stored at
+    // ifdOffset from the TIFF header, e.g. when appending to a TIFF file
+    static void writeIfdAt(uint8_t* ifd, uint32_t ifdOffset, const std::vector<ExifTag>& ifdTags, uint32_t nextIfdOffset, bool bigendian) {
+        uint8_t* entry = ifd;
+        putUInt16(entry, static_cast<uint16_t>(ifdTags.size()), bigendian);
+        entry += 2;
+
+        // Calculate data position (just after IFD entries and next IFD offset)
+        size_t dataPos = 2 + (ifdTags.size() * 12) + 4;
 
         // Process each tag
-        for (auto& tag : tags) {
-            appendUInt16(exifBlob, tag.tag, bigendian);
-            appendUInt16(exifBlob, tag.type, bigendian);
-            appendUInt32(exifBlob, tag.count, bigendian);
+        for (const auto& tag : ifdTags) {
+            putUInt16(entry, tag.tag, bigendian);
+            putUInt16(entry + 2, tag.type, bigendian);
+            putUInt32(entry + 4, tag.count, bigendian);
 
             if (tagFitsInField(tag)) {
-                writeTagValue(exifBlob, tag, bigendian); // Write values directly as is
+                // Values are left-justified in the field, padded with zeros
+                std::memset(entry + 8, 0, 4);
+                writeTagValue(entry + 8, tag, bigendian);
             }
             else {
-                appendUInt32(exifBlob, static_cast<uint32_t>(dataOffset), bigendian);
-                appendExtraData(tag, dataOffset, bigendian);
+                putUInt32(entry + 8, static_cast<uint32_t>(ifdOffset + dataPos), bigendian);
+                writeTagValue(ifd + dataPos, tag, bigendian);
+                dataPos += tag.value.size();
+                // add a padding 0 byte.
+                if (tag.value.size() % 2 != 0) {
+                    ifd[dataPos++] = 0;
+                }
             }
+            entry += 12;
         }
 
         // Write the next IFD offset (0 indicates no more IFDs)
-        appendUInt32(exifBlob, 0);
-
-        // Append the extra data (strings, RATIONALs, etc.)
-        exifBlob.insert(exifBlob.end(), extraData.begin(), extraData.end());
+        putUInt32(entry, nextIfdOffset, bigendian);
+    }
 
-        // Update the APP1 segment length
-        uint16_t exifLength = static_cast<uint16_t>(exifBlob.size() - 2); // Length excluding the APP1 marker (FF E1)
-        exifBlob[2] = (exifLength >> 8) & 0xFF;
-        exifBlob[3] = exifLength & 0xFF;
+    static bool tagFitsInField(const ExifTag& tag) {
+        // RATIONAL and SRATIONAL (8 bytes) are always stored in extra data
+        return tag.value.size() <= 4;
+    }
 
-        return exifBlob;
+    // Size of a single value of the given type, 0 for unknown types
+    static size_t typeSize(uint16_t type) {
+        switch (type) {
+        case 0x0001: // BYTE
+        case 0x0002: // ASCII
+        case 0x0007: // UNDEFINED
+            return 1;
+        case 0x0003: // SHORT
+            return 2;
+        case 0x0004: // LONG
+        case 0x0009: // SLONG
+            return 4;
+        case 0x0005: // RATIONAL
+        case 0x000A: // SRATIONAL
+            return 8;
+        }
+        return 0;
     }
 
-private:
-    // Corrected function to append a 16-bit integer in big-endian format to a vector
-    static void appendUInt16(std::vector<uint8_t>& vec, uint16_t value, bool bigendian = true) {
-		if (bigendian) {
-			vec.push_back((value >> 8) & 0xFF);
-			vec.push_back(value & 0xFF);
+    static void putUInt16(uint8_t* dst, uint16_t value, bool bigendian = true) {
+        if (bigendian) {
+            dst[0] = (value >> 8) & 0xFF;
+            dst[1] = value & 0xFF;
         }
         else {
-            vec.push_back(value & 0xFF);
-            vec.push_back((value >> 8) & 0xFF);
+            dst[0] = value & 0xFF;
+            dst[1] = (value >> 8) & 0xFF;
         }
     }
 
-    // Corrected function to append a 32-bit integer in big-endian format to a vector
-    static void appendUInt32(std::vector<uint8_t>& vec, uint32_t value, bool bigendian = true) {
+    static void putUInt32(uint8_t* dst, uint32_t value, bool bigendian = true) {
         if (bigendian) {
-            vec.push_back((value >> 24) & 0xFF);
-            vec.push_back((value >> 16) & 0xFF);
-            vec.push_back((value >> 8) & 0xFF);
-            vec.push_back(value & 0xFF);
-		}
-		else {
-			vec.push_back(value & 0xFF);
-			vec.push_back((value >> 8) & 0xFF);
-			vec.push_back((value >> 16) & 0xFF);
-			vec.push_back((value >> 24) & 0xFF);
-		}
-    }
-
-    void writeTagValue(std::vector<uint8_t>& buffer, const ExifTag& tag, bool bigendian = true) {
-        // byte order alwas from left to the right.
-        // in case of SHORT, added a padding 0 byte to the right.
-        // in case of less 4-bytes STRING, added a padding 0 byte to the right,
-        // otherwise use an offset to the extra data.
-        // big endian similar to the standard writing, little endian inverted (intel/x86/x64).
-        size_t bufSize = buffer.size();
-        switch (tag.type) {
-        case 0x0001: // BYTE
-            buffer.resize(bufSize + 4, 0);
-            buffer[bufSize] = tag.value[0];
-            break;
-        case 0x0003: // SHORT
-            buffer.resize(bufSize + 4, 0);
-            buffer[bufSize + (bigendian ? 1 : 0)] = tag.value[0];
-            buffer[bufSize + (bigendian ? 0 : 1)] = tag.value[1];
-            break;
-        case 0x0004: // LONG
-        case 0x0009: // SLONG
-            buffer.resize(bufSize + 4, 0);
-            buffer[bufSize + (bigendian ? 3 : 0)] = tag.value[0];
-            buffer[bufSize + (bigendian ? 2 : 1)] = tag.value[1];
-            buffer[bufSize + (bigendian ? 1 : 2)] = tag.value[2];
-            buffer[bufSize + (bigendian ? 0 : 3)] = tag.value[3];
-            break;
-        case 0x0002: // ASCII
-            buffer.resize(bufSize + tag.value.size(), 0);
-            std::copy(tag.value.begin(), tag.value.end(), buffer.begin() + bufSize);
-            break;
+            dst[0] = (value >> 24) & 0xFF;
+            dst[1] = (value >> 16) & 0xFF;
+            dst[2] = (value >> 8) & 0xFF;
+            dst[3] = value & 0xFF;
+        }
+        else {
+            dst[0] = value & 0xFF;
+            dst[1] = (value >> 8) & 0xFF;
+            dst[2] = (value >> 16) & 0xFF;
+            dst[3] = (value >> 24) & 0xFF;
         }
     }
 
-    bool tagFitsInField(const ExifTag& tag) const {
-        if (tag.type == 0x0001 || tag.type == 0x0003 || tag.type == 0x0004 || tag.type == 0x0009 ) {
-            return true;
+    // Writes the value of a tag in the file byte order
+    static void writeTagValue(uint8_t* dst, const ExifTag& tag, bool bigendian) {
+        // Tag values are stored in host byte order. 8-bit types are copied as is,
+        // 16-bit and 32-bit elements (RATIONALs are two 32-bit elements) are
+        // written one by one in the file byte order.
+        const uint8_t* src = tag.value.data();
+        size_t size = tag.value.size();
+        size_t elementSize = typeSize(tag.type);
+        if (elementSize == 2) {
+            for (size_t i = 0; i + 2 <= size; i += 2) {
+                uint16_t value;
+                std::memcpy(&value, src + i, 2);
+                putUInt16(dst + i, value, bigendian);
+            }
         }
-        else if (tag.type == 0x0002) {
-            return tag.value.size() <= 4;
+        else if (elementSize == 4 || elementSize == 8) {
+            for (size_t i = 0; i + 4 <= size; i += 4) {
+                uint32_t value;
+                std::memcpy(&value, src + i, 4);
+                putUInt32(dst + i, value, bigendian);
+            }
+        }
+        else {
+            std::memcpy(dst, src, size);
         }
-        // tag.type == 0x0005 (RATIONAL) is always stored in extra data
-        return false;
     }
+};
 
-    void appendExtraData(const ExifTag& tag, size_t& dataOffset, bool bigendian) {
-		const auto& data = tag.value;
-		if (bigendian || tag.type == 0x0002) {
-			extraData.insert(extraData.end(), data.begin(), data.end());
-			dataOffset += data.size();
-		}
-		else {
-			for (size_t i = data.size(); i > 0; --i) {
-				extraData.push_back(data[i - 1]);
-			}
-			dataOffset += data.size();
-		}
-        // add a padding 0 byte.
-        if (data.size() % 2 != 0) {
-            extraData.push_back(0);
-            ++dataOffset;
-        }
+////////////////////////////////////////////////////////////////////////////////////
+// JPEG helpers (MicroExif.cpp):
+//
+// - readJpegFile: reads a whole file into a new[] buffer owned by the caller.
+// - findFFDBMarker: returns the offset of the first DQT (FF DB) marker.
+// - writeNewJpegWithExif: copies originalFile to newFile with the EXIF blob
+//   inserted in front of the DQT marker.
+//
+// Each helper comes in two flavors: the plain one throws std::runtime_error,
+// the try* one returns an ExifResult. The try* helpers never throw and do not
+// allocate on failure, which keeps batch runs over damaged files fast and
+// lets callers bucket failures by ExifError instead of by message.
+//
+enum class ExifError : uint8_t {
+    None,
+    OpenFailed,         // Input file cannot be opened
+    ReadFailed,         // Input file cannot be read completely
+    CreateFailed,       // Output file cannot be created
+    WriteFailed,        // Output file cannot be written completely
+    NotJpeg,            // Data does not start with SOI (FF D8)
+    Truncated,          // Data ends inside the structure being parsed
+    MarkerNotFound,     // No DQT (FF DB) marker
+    TooLarge,           // EXIF data exceeds the APP1 segment size
+    Malformed,          // Invalid segment structure
+    Mismatch            // File or tag values differ from what was expected
+};
+
+constexpr size_t exifErrorCount = static_cast<size_t>(ExifError::Mismatch) + 1;
+
+// Static message for an error, never allocates
+const char* exifErrorString(ExifError error);
+
+// expected<>-style result: a value, or an error with the byte offset where it was detected
+template <typename T>
+struct ExifResult {
+    T value{};
+    ExifError error = ExifError::None;
+    size_t offset = 0;
+
+    explicit operator bool() const {
+        return error == ExifError::None;
+    }
+
+    static ExifResult success(T value) {
+        ExifResult result;
+        result.value = value;
+        return result;
+    }
+
+    static ExifResult failure(ExifError error, size_t offset = 0) {
+        ExifResult result;
+        result.error = error;
+        result.offset = offset;
+        return result;
     }
 };
+
+uint8_t* readJpegFile(const std::string& filename, size_t& fileSize);
+size_t findFFDBMarker(const uint8_t* jpegData, size_t fileSize);
+void writeNewJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize);
+
+ExifResult<uint8_t*> tryReadJpegFile(const std::string& filename, size_t& fileSize);
+ExifResult<size_t> tryFindFFDBMarker(const uint8_t* jpegData, size_t fileSize);
+ExifResult<size_t> tryWriteNewJpegWithExif(const std::string& originalFile, const std::string& newFile, const uint8_t* exifBlob, size_t exifSize);
@@ -0,0 +1,329 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "MicroExif.h"
+#include "MicroExifC.h"
+
+struct mexif_builder {
+	ExifBuilder builder;
+};
+
+namespace {
+
+// Sets a tag from a host-order value, see ExifBuilder::setTagValue()
+mexif_status setValue(mexif_builder* handle, uint16_t tag, uint16_t type, uint32_t count, const void* data, size_t size) {
+	if (!handle || (size != 0 && !data)) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	try {
+		handle->builder.setTagValue(tag, type, count, data, size);
+	}
+	catch (const std::bad_alloc&) {
+		return MEXIF_E_NO_MEMORY;
+	}
+	return MEXIF_OK;
+}
+
+// Offset of the first DQT marker, or size if there is none
+size_t scanForFFDB(const uint8_t* data, size_t size) {
+	for (size_t i = 0; i + 1 < size; ++i) {
+		if (data[i] == 0xFF && data[i + 1] == 0xDB) {
+			return i;
+		}
+	}
+	return size;
+}
+
+mexif_status toStatus(ExifError error) {
+	switch (error) {
+	case ExifError::None: return MEXIF_OK;
+	case ExifError::NotJpeg: return MEXIF_E_NOT_JPEG;
+	case ExifError::Truncated: return MEXIF_E_NOT_JPEG;
+	case ExifError::MarkerNotFound: return MEXIF_E_MARKER_NOT_FOUND;
+	case ExifError::TooLarge: return MEXIF_E_TOO_LARGE;
+	case ExifError::Malformed: return MEXIF_E_NOT_JPEG;
+	default: return MEXIF_E_IO;
+	}
+}
+
+long readSome(int fd, uint8_t* buffer, size_t size) {
+	for (;;) {
+#ifdef _WIN32
+		long n = _read(fd, buffer, static_cast<unsigned int>(size));
+#else
+		long n = static_cast<long>(read(fd, buffer, size));
+#endif
+		if (n >= 0 || errno != EINTR) {
+			return n;
+		}
+	}
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+	while (size > 0) {
+#ifdef _WIN32
+		long n = _write(fd, data, static_cast<unsigned int>(size > 0x40000000 ? 0x40000000 : size));
+#else
+		long n = static_cast<long>(write(fd, data, size));
+#endif
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+} // namespace
+
+extern "C" {
+
+mexif_builder* mexif_builder_new(void) {
+	return new (std::nothrow) mexif_builder();
+}
+
+void mexif_builder_free(mexif_builder* builder) {
+	delete builder;
+}
+
+void mexif_builder_clear(mexif_builder* builder) {
+	if (builder) {
+		builder->builder.clear();
+	}
+}
+
+mexif_status mexif_set_byte(mexif_builder* builder, uint16_t tag, uint8_t value) {
+	return setValue(builder, tag, 0x0001, 1, &value, 1);
+}
+
+mexif_status mexif_set_short(mexif_builder* builder, uint16_t tag, uint16_t value) {
+	return setValue(builder, tag, 0x0003, 1, &value, 2);
+}
+
+mexif_status mexif_set_long(mexif_builder* builder, uint16_t tag, uint32_t value) {
+	return setValue(builder, tag, 0x0004, 1, &value, 4);
+}
+
+mexif_status mexif_set_slong(mexif_builder* builder, uint16_t tag, int32_t value) {
+	return setValue(builder, tag, 0x0009, 1, &value, 4);
+}
+
+mexif_status mexif_set_rational(mexif_builder* builder, uint16_t tag, uint32_t numerator, uint32_t denominator) {
+	uint32_t value[2] = { numerator, denominator };
+	return setValue(builder, tag, 0x0005, 1, value, 8);
+}
+
+mexif_status mexif_set_srational(mexif_builder* builder, uint16_t tag, int32_t numerator, int32_t denominator) {
+	int32_t value[2] = { numerator, denominator };
+	return setValue(builder, tag, 0x000A, 1, value, 8);
+}
+
+mexif_status mexif_set_ascii(mexif_builder* builder, uint16_t tag, const char* value, size_t len) {
+	if (!builder || (len != 0 && !value) || len >= 0xFFFF) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	try {
+		builder->builder.setTagString(tag, value, len);
+	}
+	catch (const std::bad_alloc&) {
+		return MEXIF_E_NO_MEMORY;
+	}
+	return MEXIF_OK;
+}
+
+mexif_status mexif_set_undefined(mexif_builder* builder, uint16_t tag, const uint8_t* data, size_t len) {
+	if (len > 0xFFFF) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	return setValue(builder, tag, 0x0007, static_cast<uint32_t>(len), data, len);
+}
+
+mexif_status mexif_remove(mexif_builder* builder, uint16_t tag) {
+	if (!builder) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	builder->builder.removeTag(tag);
+	return MEXIF_OK;
+}
+
+mexif_status mexif_blob_size(const mexif_builder* builder, size_t* len) {
+	if (!builder || !len) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	*len = builder->builder.exifBlobSize();
+	return *len - 2 > 0xFFFF ? MEXIF_E_TOO_LARGE : MEXIF_OK;
+}
+
+mexif_status mexif_build_into(const mexif_builder* builder, uint8_t* buf, size_t cap, size_t* len) {
+	mexif_status status = mexif_blob_size(builder, len);
+	if (status != MEXIF_OK) {
+		return status;
+	}
+	if (!buf || *len > cap) {
+		return MEXIF_E_BUFFER_TOO_SMALL;
+	}
+	builder->builder.buildExifBlobInto(buf, cap);
+	return MEXIF_OK;
+}
+
+mexif_status mexif_inject_into(const uint8_t* jpeg, size_t jpeg_len, const uint8_t* blob, size_t blob_len,
+	uint8_t* out, size_t cap, size_t* len) {
+	if (!jpeg || !len || (blob_len != 0 && !blob)) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+	auto marker = tryFindFFDBMarker(jpeg, jpeg_len);
+	if (!marker) {
+		return toStatus(marker.error);
+	}
+	size_t markerPos = marker.value;
+	*len = jpeg_len + blob_len;
+	if (!out || *len > cap) {
+		return MEXIF_E_BUFFER_TOO_SMALL;
+	}
+	std::memcpy(out, jpeg, markerPos);
+	std::memcpy(out + markerPos, blob, blob_len);
+	std::memcpy(out + markerPos + blob_len, jpeg + markerPos, jpeg_len - markerPos);
+	return MEXIF_OK;
+}
+
+mexif_status mexif_inject_fd(int in_fd, int out_fd, const uint8_t* blob, size_t blob_len) {
+	if (in_fd < 0 || out_fd < 0 || (blob_len != 0 && !blob)) {
+		return MEXIF_E_INVALID_ARGUMENT;
+	}
+
+	uint8_t buffer[64 * 1024];
+	bool checkedSoi = false;
+	bool injected = false;
+	bool pendingFF = false;     // Previous chunk ended with 0xFF
+	for (;;) {
+		long n = readSome(in_fd, buffer, sizeof(buffer));
+		if (n == 1 && !checkedSoi) {
+			// A pipe or socket may deliver the first byte alone, SOI needs two
+			long more = readSome(in_fd, buffer + 1, sizeof(buffer) - 1);
+			n = more < 0 ? more : n + more;
+		}
+		if (n < 0) {
+			return MEXIF_E_IO;
+		}
+		if (n == 0) {
+			break;
+		}
+		size_t size = static_cast<size_t>(n);
+		bool firstChunk = !checkedSoi;
+		size_t markerPos = size;
+		if (firstChunk) {
+			// SOI check and marker search as in mexif_inject_into
+			auto marker = tryFindFFDBMarker(buffer, size);
+			if (!marker && marker.error != ExifError::MarkerNotFound) {
+				return MEXIF_E_NOT_JPEG;
+			}
+			markerPos = marker ? marker.value : size;
+			checkedSoi = true;
+		}
+		if (injected) {
+			if (!writeAll(out_fd, buffer, size)) {
+				return MEXIF_E_IO;
+			}
+			continue;
+		}
+
+		if (pendingFF && buffer[0] == 0xDB) {
+			// The marker straddles the chunk boundary: the held back 0xFF comes after the blob
+			const uint8_t ff = 0xFF;
+			pendingFF = false;
+			if (!writeAll(out_fd, blob, blob_len) || !writeAll(out_fd, &ff, 1) || !writeAll(out_fd, buffer, size)) {
+				return MEXIF_E_IO;
+			}
+			injected = true;
+			continue;
+		}
+		if (pendingFF) {
+			const uint8_t ff = 0xFF;
+			pendingFF = false;
+			if (!writeAll(out_fd, &ff, 1)) {
+				return MEXIF_E_IO;
+			}
+		}
+
+		if (!firstChunk) {
+			markerPos = scanForFFDB(buffer, size);
+		}
+		if (markerPos < size) {
+			if (!writeAll(out_fd, buffer, markerPos) || !writeAll(out_fd, blob, blob_len)
+				|| !writeAll(out_fd, buffer + markerPos, size - markerPos)) {
+				return MEXIF_E_IO;
+			}
+			injected = true;
+			continue;
+		}
+
+		// Hold back a trailing 0xFF, it may start the marker in the next chunk
+		pendingFF = buffer[size - 1] == 0xFF;
+		if (!writeAll(out_fd, buffer, pendingFF ? size - 1 : size)) {
+			return MEXIF_E_IO;
+		}
+	}
+
+	if (!checkedSoi) {
+		return MEXIF_E_NOT_JPEG;
+	}
+	if (pendingFF) {
+		const uint8_t ff = 0xFF;
+		if (!writeAll(out_fd, &ff, 1)) {
+			return MEXIF_E_IO;
+		}
+	}
+	return injected ? MEXIF_OK : MEXIF_E_MARKER_NOT_FOUND;
+}
+
+const char* mexif_status_string(mexif_status status) {
+	switch (status) {
+	case MEXIF_OK: return "ok";
+	case MEXIF_E_INVALID_ARGUMENT: return "invalid argument";
+	case MEXIF_E_BUFFER_TOO_SMALL: return "buffer too small";
+	case MEXIF_E_TOO_LARGE: return "EXIF data exceeds the APP1 segment size";
+	case MEXIF_E_NO_MEMORY: return "out of memory";
+	case MEXIF_E_NOT_JPEG: return "not a JPEG file";
+	case MEXIF_E_MARKER_NOT_FOUND: return "FFDB marker not found";
+	case MEXIF_E_IO: return "I/O error";
+	}
+	return "unknown status";
+}
+
+} // extern "C"
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////////
+// MicroEXIF C API:
+//
+// A stable C interface for bindings (Python ctypes/cffi, Go cgo, Rust FFI).
+// The library never hands out memory it owns: blobs and injected JPEGs are
+// written into buffers supplied by the caller, so a caller can serialize
+// straight into a bytearray, a numpy buffer or a Go slice.
+//
+// - No function throws, all of them return a mexif_status.
+// - No function takes a lock or calls back into the caller, so the Python
+//   GIL can be released around every call.
+// - A builder must not be used from several threads at the same time;
+//   different builders are independent.
+// - mexif_build_into() never allocates. The mexif_set_* functions only
+//   allocate when a tag is added or grows, so updating a per-frame value
+//   (e.g. DateTimeOriginal) in a steady state is allocation-free as well.
+//
+// Integer values are passed in host byte order, the builder writes them in
+// the byte order of the EXIF blob.
+//
+#if defined(_WIN32) && defined(MEXIF_SHARED)
+#define MEXIF_API __declspec(dllexport)
+#elif defined(__GNUC__) && defined(MEXIF_SHARED)
+#define MEXIF_API __attribute__((visibility("default")))
+#else
+#define MEXIF_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum mexif_status {
+    MEXIF_OK = 0,
+    MEXIF_E_INVALID_ARGUMENT = 1,   // NULL pointer or unusable value
+    MEXIF_E_BUFFER_TOO_SMALL = 2,   // *len is set to the required size
+    MEXIF_E_TOO_LARGE = 3,          // Tags do not fit into one APP1 segment
+    MEXIF_E_NO_MEMORY = 4,
+    MEXIF_E_NOT_JPEG = 5,           // Input does not start with SOI (FF D8)
+    MEXIF_E_MARKER_NOT_FOUND = 6,   // No DQT (FF DB) marker to insert in front of
+    MEXIF_E_IO = 7                  // read() or write() failed, see errno
+} mexif_status;
+
+typedef struct mexif_builder mexif_builder;
+
+// Returns NULL if out of memory
+MEXIF_API mexif_builder* mexif_builder_new(void);
+MEXIF_API void mexif_builder_free(mexif_builder* builder);
+MEXIF_API void mexif_builder_clear(mexif_builder* builder);
+
+// Set a tag, replacing an existing tag with the same ID
+MEXIF_API mexif_status mexif_set_byte(mexif_builder* builder, uint16_t tag, uint8_t value);
+MEXIF_API mexif_status mexif_set_short(mexif_builder* builder, uint16_t tag, uint16_t value);
+MEXIF_API mexif_status mexif_set_long(mexif_builder* builder, uint16_t tag, uint32_t value);
+MEXIF_API mexif_status mexif_set_slong(mexif_builder* builder, uint16_t tag, int32_t value);
+MEXIF_API mexif_status mexif_set_rational(mexif_builder* builder, uint16_t tag, uint32_t numerator, uint32_t denominator);
+MEXIF_API mexif_status mexif_set_srational(mexif_builder* builder, uint16_t tag, int32_t numerator, int32_t denominator);
+// value does not need to be NUL-terminated, the terminator is added
+MEXIF_API mexif_status mexif_set_ascii(mexif_builder* builder, uint16_t tag, const char* value, size_t len);
+MEXIF_API mexif_status mexif_set_undefined(mexif_builder* builder, uint16_t tag, const uint8_t* data, size_t len);
+MEXIF_API mexif_status mexif_remove(mexif_builder* builder, uint16_t tag);
+
+// Size of the APP1 segment that mexif_build_into() writes
+MEXIF_API mexif_status mexif_blob_size(const mexif_builder* builder, size_t* len);
+
+// Serializes the APP1 segment into buf. On MEXIF_E_BUFFER_TOO_SMALL *len
+// holds the required capacity.
+MEXIF_API mexif_status mexif_build_into(const mexif_builder* builder, uint8_t* buf, size_t cap, size_t* len);
+
+// Writes jpeg with the blob inserted in front of the DQT marker into out.
+// The output is always jpeg_len + blob_len bytes.
+MEXIF_API mexif_status mexif_inject_into(const uint8_t* jpeg, size_t jpeg_len, const uint8_t* blob, size_t blob_len,
+    uint8_t* out, size_t cap, size_t* len);
+
+// Streams a JPEG from in_fd to out_fd with the blob inserted, using a fixed
+// stack buffer. Both descriptors are left open and are not rewound.
+// On MEXIF_E_MARKER_NOT_FOUND out_fd has received a complete copy of the
+// input without the blob, on other errors a partial one.
+MEXIF_API mexif_status mexif_inject_fd(int in_fd, int out_fd, const uint8_t* blob, size_t blob_len);
+
+MEXIF_API const char* mexif_status_string(mexif_status status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "MicroExifProbes.h"
+
+#if MICROEXIF_HAVE_PROBES
+
+// Semaphores live in the ".probes" section, where tracers expect them
+#define MICROEXIF_DEFINE_PROBE_SEMAPHORE_(name) \
+	volatile unsigned short MICROEXIF_PROBE_SEMAPHORE_(name) __attribute__((section(".probes"), used)) = 0
+
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(build__start);
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(build__end);
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(segment__walk);
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(write__start);
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(write__end);
+MICROEXIF_DEFINE_PROBE_SEMAPHORE_(file__done);
+
+#endif
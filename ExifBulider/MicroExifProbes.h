@@ -0,0 +1,162 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+////////////////////////////////////////////////////////////////////////////////////
+// USDT probes:
+//
+// Static tracepoints compatible with sys/sdt.h (provider "microexif"), usable
+// from bpftrace, perf and SystemTap without recompiling, e.g.
+//
+//   bpftrace -e 'usdt:./MicroExif:microexif:file__done { @us = hist(arg2 / 1000); }'
+//
+// Each probe site is a single nop plus an ELF note, so a disabled probe costs
+// next to nothing. Probes carry an is-enabled semaphore that the tracer raises
+// while attached; durations are only measured when it is set.
+//
+// Probes (all arguments are 64-bit):
+//   build__start    (tagCount)
+//   build__end      (tagCount, blobSize, durationNs)
+//   segment__walk   (markerOffset, fileSize, found)
+//   write__start    (fileSize, exifSize)
+//   write__end      (bytesWritten, durationNs)
+//   file__done      (newFile, outputSize, durationNs)
+//
+// The probes are only emitted for GCC/Clang on Linux x86-64 and AArch64;
+// define MICROEXIF_NO_PROBES to compile them out everywhere.
+//
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(MICROEXIF_NO_PROBES)
+#define MICROEXIF_HAVE_PROBES 1
+#else
+#define MICROEXIF_HAVE_PROBES 0
+#endif
+
+#if MICROEXIF_HAVE_PROBES
+
+#define MICROEXIF_PROBE_SEMAPHORE_(name) microexif_##name##_semaphore
+
+// Semaphores are defined once in MicroExifProbes.cpp. Inline definitions
+// would share one COMDAT group in ".probes" whose name depends on the
+// optimization level, so objects built with different flags would not link.
+#define MICROEXIF_DECLARE_PROBE_SEMAPHORE_(name) \
+    extern volatile unsigned short MICROEXIF_PROBE_SEMAPHORE_(name)
+
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(build__start);
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(build__end);
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(segment__walk);
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(write__start);
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(write__end);
+MICROEXIF_DECLARE_PROBE_SEMAPHORE_(file__done);
+
+#define MICROEXIF_PROBE_ENABLED(name) (MICROEXIF_PROBE_SEMAPHORE_(name) != 0)
+
+// Emits the probe nop and its .note.stapsdt entry (layout as in sys/sdt.h v3)
+#define MICROEXIF_PROBE_ASM_(name, args, ...) \
+    __asm__ __volatile__ ( \
+        "990: nop\n" \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+        ".balign 4\n" \
+        ".4byte 992f-991f, 994f-993f, 3\n" \
+        "991: .asciz \"stapsdt\"\n" \
+        "992: .balign 4\n" \
+        "993: .8byte 990b\n" \
+        ".8byte _.stapsdt.base\n" \
+        ".8byte microexif_" #name "_semaphore\n" \
+        ".asciz \"microexif\"\n" \
+        ".asciz \"" #name "\"\n" \
+        ".asciz \"" args "\"\n" \
+        "994: .balign 4\n" \
+        ".popsection\n" \
+        ".ifndef _.stapsdt.base\n" \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n" \
+        ".hidden _.stapsdt.base\n" \
+        "_.stapsdt.base: .space 1\n" \
+        ".size _.stapsdt.base, 1\n" \
+        ".popsection\n" \
+        ".endif\n" \
+        :: __VA_ARGS__)
+
+#define MICROEXIF_PROBE_ARG_(a) "nor"((uint64_t)(a))
+
+#define MICROEXIF_PROBE1(name, a1) \
+    MICROEXIF_PROBE_ASM_(name, "8@%0", MICROEXIF_PROBE_ARG_(a1))
+#define MICROEXIF_PROBE2(name, a1, a2) \
+    MICROEXIF_PROBE_ASM_(name, "8@%0 8@%1", MICROEXIF_PROBE_ARG_(a1), MICROEXIF_PROBE_ARG_(a2))
+#define MICROEXIF_PROBE3(name, a1, a2, a3) \
+    MICROEXIF_PROBE_ASM_(name, "8@%0 8@%1 8@%2", MICROEXIF_PROBE_ARG_(a1), MICROEXIF_PROBE_ARG_(a2), MICROEXIF_PROBE_ARG_(a3))
+
+#else
+
+#define MICROEXIF_PROBE_ENABLED(name) false
+#define MICROEXIF_PROBE1(name, a1) ((void)0)
+#define MICROEXIF_PROBE2(name, a1, a2) ((void)0)
+#define MICROEXIF_PROBE3(name, a1, a2, a3) ((void)0)
+
+#endif
+
+// Monotonic timestamp for probe durations
+inline uint64_t microexifProbeClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// write__start/write__end/file__done for one output file, shared by the write
+// paths; the clock is only read while a tracer is attached
+struct MicroExifWriteProbes {
+    uint64_t fileStartNs = MICROEXIF_PROBE_ENABLED(file__done) ? microexifProbeClockNs() : 0;
+    uint64_t writeStartNs = 0;
+
+    void writeStart(uint64_t fileSize, uint64_t exifSize) {
+        MICROEXIF_PROBE2(write__start, fileSize, exifSize);
+        writeStartNs = MICROEXIF_PROBE_ENABLED(write__end) ? microexifProbeClockNs() : 0;
+    }
+
+    // For paths that stream the input without knowing its size; the size is
+    // only looked up while write__start is traced
+    void writeStart(const std::string& originalFile, uint64_t exifSize) {
+        uint64_t fileSize = 0;
+        if (MICROEXIF_PROBE_ENABLED(write__start)) {
+            std::error_code error;
+            auto size = std::filesystem::file_size(originalFile, error);
+            fileSize = error ? 0 : static_cast<uint64_t>(size);
+        }
+        writeStart(fileSize, exifSize);
+    }
+
+    void done(const char* newFile, uint64_t outputSize) {
+        if (writeStartNs != 0) {
+            MICROEXIF_PROBE2(write__end, outputSize, microexifProbeClockNs() - writeStartNs);
+        }
+        if (fileStartNs != 0) {
+            MICROEXIF_PROBE3(file__done, newFile, outputSize, microexifProbeClockNs() - fileStartNs);
+        }
+    }
+};
@@ -0,0 +1,134 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "JpegHeader.h"
+#include "MappedFile.h"
+#include "MjpegIndexer.h"
+
+namespace {
+
+struct FrameCandidate {
+	size_t offset;
+	size_t headerSize;
+};
+
+// Finds the validated SOI candidates that start in [begin, end)
+void scanRange(const uint8_t* data, size_t size, size_t begin, size_t end, std::vector<FrameCandidate>& candidates) {
+	JpegHeaderLayout layout;
+	size_t pos = begin;
+	while (pos < end) {
+		const void* hit = std::memchr(data + pos, 0xFF, end - pos);
+		if (!hit) {
+			break;
+		}
+		pos = static_cast<const uint8_t*>(hit) - data;
+		if (pos + 3 < size && data[pos + 1] == 0xD8 && data[pos + 2] == 0xFF) {
+			layout.reset();
+			if (scanJpegHeader(data + pos, size - pos, layout)) {
+				candidates.push_back({ pos, layout.headerSize });
+				// Nothing inside this header can start another frame
+				pos += layout.headerSize;
+				continue;
+			}
+		}
+		++pos;
+	}
+}
+
+// Offset just past the last EOI in [begin, end), or 0 if there is none
+size_t findLastEoi(const uint8_t* data, size_t begin, size_t end) {
+	for (size_t pos = end; pos >= begin + 2; --pos) {
+		if (data[pos - 2] == 0xFF && data[pos - 1] == 0xD9) {
+			return pos;
+		}
+	}
+	return 0;
+}
+
+} // namespace
+
+ExifResult<size_t> indexMjpegBuffer(const uint8_t* data, size_t size, std::vector<MjpegFrameInfo>& frames,
+	const MjpegIndexOptions& options) {
+	frames.clear();
+
+	unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+	size_t maxRanges = std::max<size_t>(1, size / std::max<size_t>(1, options.minRangeSize));
+	size_t ranges = std::min<size_t>(threads, maxRanges);
+	size_t rangeSize = (size + ranges - 1) / std::max<size_t>(1, ranges);
+
+	std::vector<std::vector<FrameCandidate>> found(ranges);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < ranges; ++i) {
+		workers.emplace_back(scanRange, data, size, i * rangeSize, std::min(size, (i + 1) * rangeSize), std::ref(found[i]));
+	}
+	scanRange(data, size, 0, std::min(size, rangeSize), found[0]);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Merge in file order, a range may have resynchronized inside a frame
+	// header accepted by the previous range
+	std::vector<FrameCandidate> starts;
+	size_t headerEnd = 0;
+	for (const auto& range : found) {
+		for (const auto& candidate : range) {
+			if (candidate.offset >= headerEnd) {
+				starts.push_back(candidate);
+				headerEnd = candidate.offset + candidate.headerSize;
+			}
+		}
+	}
+
+	frames.reserve(starts.size());
+	for (size_t i = 0; i < starts.size(); ++i) {
+		size_t begin = starts[i].offset;
+		size_t limit = i + 1 < starts.size() ? starts[i + 1].offset : size;
+
+		MjpegFrameInfo info;
+		info.offset = begin;
+		info.timestampUs = static_cast<int64_t>(i);
+		size_t end = findLastEoi(data, begin + starts[i].headerSize, limit);
+		if (end == 0) {
+			end = limit;
+			info.flags |= MjpegFrameNoEoi;
+		}
+		info.size = static_cast<uint32_t>(std::min<size_t>(end - begin, UINT32_MAX));
+		frames.push_back(info);
+	}
+	return ExifResult<size_t>::success(frames.size());
+}
+
+ExifResult<size_t> indexMjpegFile(const std::string& filename, std::vector<MjpegFrameInfo>& frames,
+	const MjpegIndexOptions& options) {
+	MappedFile file;
+	auto mapped = file.open(filename);
+	if (!mapped) {
+		return mapped;
+	}
+	return indexMjpegBuffer(file.data(), file.size(), frames, options);
+}
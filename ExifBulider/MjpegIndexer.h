@@ -0,0 +1,60 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MicroExif.h"
+#include "MjpegRecording.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Parallel MJPEG frame indexer:
+//
+// Builds the frame table of a raw MJPEG capture (concatenated JPEG files
+// without any index). The mapped file is split into one range per thread.
+// Each thread searches its range for SOI candidates (FF D8 FF) with memchr
+// and validates every candidate by walking its header up to SOS. Candidates
+// are validated against the whole mapping, so a frame that starts near the
+// end of a range is resynchronized across the boundary. The merge step drops
+// candidates that lie inside the header of an accepted frame (e.g. EXIF
+// thumbnails) and ends each frame at the last EOI in front of the next one.
+//
+// The resulting table uses MjpegFrameInfo (see MjpegRecording.h); the
+// timestamp holds the frame number, and flags has MjpegFrameNoEoi set for a
+// frame whose EOI marker is missing.
+//
+constexpr uint32_t MjpegFrameNoEoi = 0x0001;
+
+struct MjpegIndexOptions {
+    unsigned threads = 0;                   // 0 = all hardware threads
+    size_t minRangeSize = 16 << 20;         // Smaller files use fewer threads
+};
+
+// The value of the result is the number of frames
+ExifResult<size_t> indexMjpegBuffer(const uint8_t* data, size_t size, std::vector<MjpegFrameInfo>& frames,
+    const MjpegIndexOptions& options = MjpegIndexOptions());
+ExifResult<size_t> indexMjpegFile(const std::string& filename, std::vector<MjpegFrameInfo>& frames,
+    const MjpegIndexOptions& options = MjpegIndexOptions());
@@ -0,0 +1,326 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "MjpegRecording.h"
+
+namespace {
+
+const char headerMagic[8] = { 'M', 'X', 'R', 'E', 'C', 0, 0, 0 };
+const char indexMagic[8] = { 'M', 'X', 'I', 'N', 'D', 'E', 'X', 0 };
+const char footerMagic[8] = { 'M', 'X', 'R', 'F', 'O', 'O', 'T', 0 };
+
+constexpr uint32_t recordingVersion = 1;
+constexpr size_t headerSize = 16;
+constexpr size_t indexHeaderSize = 24;
+constexpr size_t entrySize = 24;
+constexpr size_t footerSize = 24;
+
+void putUInt64(uint8_t* dst, uint64_t value) {
+	ExifBuilder::putUInt32(dst, static_cast<uint32_t>(value), false);
+	ExifBuilder::putUInt32(dst + 4, static_cast<uint32_t>(value >> 32), false);
+}
+
+uint32_t getUInt32(const uint8_t* src) {
+	return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8)
+		| (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+uint64_t getUInt64(const uint8_t* src) {
+	return static_cast<uint64_t>(getUInt32(src)) | (static_cast<uint64_t>(getUInt32(src + 4)) << 32);
+}
+
+MjpegFrameInfo decodeEntry(const uint8_t* entry) {
+	MjpegFrameInfo info;
+	info.offset = getUInt64(entry);
+	info.size = getUInt32(entry + 8);
+	info.flags = getUInt32(entry + 12);
+	info.timestampUs = static_cast<int64_t>(getUInt64(entry + 16));
+	return info;
+}
+
+// Checks that an index block at offset lies within the file and only
+// references frames in front of it
+bool validIndexBlock(const uint8_t* data, size_t size, uint64_t offset) {
+	if (offset < headerSize || offset + indexHeaderSize > size || std::memcmp(data + offset, indexMagic, 8) != 0) {
+		return false;
+	}
+	uint64_t count = getUInt32(data + offset + 8);
+	if (offset + indexHeaderSize + count * entrySize > size) {
+		return false;
+	}
+	for (uint64_t i = 0; i < count; ++i) {
+		MjpegFrameInfo info = decodeEntry(data + offset + indexHeaderSize + i * entrySize);
+		if (info.offset < headerSize || info.offset + info.size > offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////
+// MjpegRecorder
+
+ExifResult<size_t> MjpegRecorder::open(const std::string& filename, uint32_t interval, const ThreadPlacement& placement, unsigned stream) {
+	close();
+	file = fopen(filename.c_str(), "wb");
+	if (!file) {
+		return ExifResult<size_t>::failure(ExifError::CreateFailed);
+	}
+	// Appends are sequential, a large stdio buffer keeps the write calls few
+	char* buffer = nullptr;
+	if (placement.mode != ThreadPlacement::Mode::None && applyThreadPlacement(placement, stream)
+		&& writeBuffer.allocate(1 << 20, currentNumaNode())) {
+		buffer = reinterpret_cast<char*>(writeBuffer.data());
+	}
+	setvbuf(file, buffer, _IOFBF, 1 << 20);
+
+	uint8_t header[headerSize] = {};
+	std::memcpy(header, headerMagic, 8);
+	ExifBuilder::putUInt32(header + 8, recordingVersion, false);
+	if (fwrite(header, 1, headerSize, file) != headerSize) {
+		fclose(file);
+		file = nullptr;
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+
+	position = headerSize;
+	lastIndexOffset = 0;
+	indexedFrames = 0;
+	indexInterval = interval ? interval : 1;
+	frames.clear();
+	return ExifResult<size_t>::success(0);
+}
+
+ExifResult<size_t> MjpegRecorder::appendFrame(const uint8_t* jpeg, size_t size, int64_t timestampUs,
+	const uint8_t* exifBlob, size_t exifSize, uint32_t flags) {
+	if (!file || failed) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed, static_cast<size_t>(position));
+	}
+	if (size < 2 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+		return ExifResult<size_t>::failure(ExifError::NotJpeg);
+	}
+	bool inject = exifBlob && exifSize > 0;
+	uint64_t frameSize = static_cast<uint64_t>(size) + (inject ? exifSize : 0);
+	if (frameSize > UINT32_MAX) {
+		return ExifResult<size_t>::failure(ExifError::TooLarge);
+	}
+
+	bool written = false;
+	if (inject) {
+		auto layout = spliceCache.lookup(jpeg, size);
+		if (!layout) {
+			return ExifResult<size_t>::failure(layout.error, layout.offset);
+		}
+		size_t insertAt = layout.value->insertOffset;
+		written = fwrite(jpeg, 1, insertAt, file) == insertAt
+			&& fwrite(exifBlob, 1, exifSize, file) == exifSize
+			&& fwrite(jpeg + insertAt, 1, size - insertAt, file) == size - insertAt;
+	}
+	else {
+		written = fwrite(jpeg, 1, size, file) == size;
+	}
+	if (!written) {
+		// Part of the frame may be in the file, later offsets would be wrong
+		failed = true;
+		return ExifResult<size_t>::failure(ExifError::WriteFailed, static_cast<size_t>(position));
+	}
+
+	MjpegFrameInfo info;
+	info.offset = position;
+	info.size = static_cast<uint32_t>(frameSize);
+	info.flags = flags;
+	info.timestampUs = timestampUs;
+	frames.push_back(info);
+	position += frameSize;
+
+	if (frames.size() - indexedFrames >= indexInterval) {
+		if (!writeIndex(indexedFrames, frames.size() - indexedFrames, true)) {
+			failed = true;
+			return ExifResult<size_t>::failure(ExifError::WriteFailed, static_cast<size_t>(position));
+		}
+		indexedFrames = frames.size();
+	}
+	return ExifResult<size_t>::success(frames.size() - 1);
+}
+
+bool MjpegRecorder::writeIndex(size_t first, size_t count, bool periodic) {
+	uint8_t block[indexHeaderSize] = {};
+	std::memcpy(block, indexMagic, 8);
+	ExifBuilder::putUInt32(block + 8, static_cast<uint32_t>(count), false);
+	// The final index is not part of the chain, it already lists every frame
+	putUInt64(block + 16, periodic ? lastIndexOffset : 0);
+	if (fwrite(block, 1, indexHeaderSize, file) != indexHeaderSize) {
+		return false;
+	}
+
+	for (size_t i = first; i < first + count; ++i) {
+		uint8_t entry[entrySize];
+		putUInt64(entry, frames[i].offset);
+		ExifBuilder::putUInt32(entry + 8, frames[i].size, false);
+		ExifBuilder::putUInt32(entry + 12, frames[i].flags, false);
+		putUInt64(entry + 16, static_cast<uint64_t>(frames[i].timestampUs));
+		if (fwrite(entry, 1, entrySize, file) != entrySize) {
+			return false;
+		}
+	}
+
+	if (periodic) {
+		lastIndexOffset = position;
+	}
+	position += indexHeaderSize + count * entrySize;
+	return true;
+}
+
+ExifResult<size_t> MjpegRecorder::close() {
+	if (!file) {
+		return ExifResult<size_t>::success(frames.size());
+	}
+
+	// The final index covers every frame, so readers never need the chain.
+	// After a failed write the offsets are unreliable: no index and no footer,
+	// readers recover the frames of the periodic indexes written before.
+	bool written = !failed;
+	if (written) {
+		uint64_t finalIndexOffset = position;
+		written = writeIndex(0, frames.size(), false);
+
+		uint8_t footer[footerSize];
+		putUInt64(footer, finalIndexOffset);
+		putUInt64(footer + 8, frames.size());
+		std::memcpy(footer + 16, footerMagic, 8);
+		written = written && fwrite(footer, 1, footerSize, file) == footerSize;
+	}
+	written = (fclose(file) == 0) && written;
+	file = nullptr;
+	failed = false;
+	writeBuffer.release();
+
+	if (!written) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+	return ExifResult<size_t>::success(frames.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// MjpegRecordingReader
+
+ExifResult<size_t> MjpegRecordingReader::open(const std::string& filename) {
+	close();
+	auto mapped = file.open(filename);
+	if (!mapped) {
+		return mapped;
+	}
+
+	const uint8_t* data = file.data();
+	size_t size = file.size();
+	if (size < headerSize || std::memcmp(data, headerMagic, 8) != 0) {
+		file.close();
+		return ExifResult<size_t>::failure(ExifError::Malformed, 0);
+	}
+
+	if (size >= headerSize + indexHeaderSize + footerSize
+		&& std::memcmp(data + size - 8, footerMagic, 8) == 0) {
+		uint64_t indexOffset = getUInt64(data + size - footerSize);
+		uint64_t frames = getUInt64(data + size - footerSize + 8);
+		if (indexOffset + indexHeaderSize + frames * entrySize == size - footerSize
+			&& validIndexBlock(data, size, indexOffset)
+			&& getUInt32(data + indexOffset + 8) == frames) {
+			entries = data + indexOffset + indexHeaderSize;
+			count = static_cast<size_t>(frames);
+			return ExifResult<size_t>::success(count);
+		}
+	}
+
+	return recover();
+}
+
+// Rebuilds the frame table from the chain of periodic indexes, starting
+// with the last index block in the file
+ExifResult<size_t> MjpegRecordingReader::recover() {
+	const uint8_t* data = file.data();
+	size_t size = file.size();
+	wasRecovered = true;
+
+	uint64_t offset = 0;
+	for (size_t pos = size >= 8 ? size - 8 : 0; pos >= headerSize; --pos) {
+		if (data[pos] == 'M' && validIndexBlock(data, size, pos)) {
+			offset = pos;
+			break;
+		}
+	}
+
+	std::vector<std::pair<uint64_t, size_t>> blocks;
+	while (offset != 0 && validIndexBlock(data, size, offset)) {
+		blocks.push_back({ offset, getUInt32(data + offset + 8) });
+		uint64_t previous = getUInt64(data + offset + 16);
+		if (previous >= offset) {
+			break;
+		}
+		offset = previous;
+	}
+
+	for (auto block = blocks.rbegin(); block != blocks.rend(); ++block) {
+		for (size_t i = 0; i < block->second; ++i) {
+			recoveredFrames.push_back(decodeEntry(data + block->first + indexHeaderSize + i * entrySize));
+		}
+	}
+	count = recoveredFrames.size();
+	return ExifResult<size_t>::success(count);
+}
+
+void MjpegRecordingReader::close() {
+	file.close();
+	entries = nullptr;
+	recoveredFrames.clear();
+	count = 0;
+	wasRecovered = false;
+}
+
+MjpegFrameInfo MjpegRecordingReader::frameInfo(size_t frame) const {
+	if (entries) {
+		return decodeEntry(entries + frame * entrySize);
+	}
+	return recoveredFrames[frame];
+}
+
+size_t MjpegRecordingReader::findFrameAtTime(int64_t timestampUs) const {
+	// First frame that is later than timestampUs, the answer is the one before
+	size_t low = 0;
+	size_t high = count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (frameInfo(middle).timestampUs <= timestampUs) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low == 0 ? 0 : low - 1;
+}
@@ -0,0 +1,137 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "JpegSpliceCache.h"
+#include "MappedFile.h"
+#include "MicroExif.h"
+#include "ThreadPlacement.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// Indexed MJPEG recording:
+//
+// A simple container for long MJPEG captures with per-frame EXIF that can be
+// seeked in O(1) by frame number and in O(log n) by timestamp.
+//
+// File layout (all integers little-endian):
+//
+//   header  "MXREC\0\0\0", u32 version, u32 reserved               16 bytes
+//   frames  complete JPEG files, appended back to back
+//   index   written every indexInterval frames and once more on close():
+//           "MXINDEX\0", u32 count, u32 reserved, u64 previous index
+//           offset (0 for none and in the final index), then count
+//           entries of u64 offset, u32 size, u32 flags,
+//           i64 timestamp (us)                                     24 bytes
+//   footer  u64 offset of the final index, u64 frame count, "MXRFOOT\0"
+//
+// The final index covers all frames, so a reader maps it and indexes into
+// it directly. The periodic indexes only cover the frames since the
+// previous index; they are chained backwards and let a reader recover a
+// recording whose writer died before close().
+//
+// Frame timestamps are expected to be non-decreasing.
+//
+// Each camera stream can be given a placement in open(): the thread that
+// records the stream is pinned with applyThreadPlacement(placement, stream)
+// and the 1 MB write buffer is then allocated as a NodeLocalBuffer on the
+// node it runs on, so frames are staged next to the capture thread.
+//
+struct MjpegFrameInfo {
+    uint64_t offset = 0;        // Offset of the SOI marker in the recording
+    uint32_t size = 0;          // Size of the JPEG including the EXIF segment
+    uint32_t flags = 0;         // Reserved for the caller
+    int64_t timestampUs = 0;
+};
+
+class MjpegRecorder {
+public:
+    MjpegRecorder() = default;
+    ~MjpegRecorder() {
+        close();
+    }
+
+    MjpegRecorder(const MjpegRecorder&) = delete;
+    MjpegRecorder& operator=(const MjpegRecorder&) = delete;
+
+    // Call from the thread that appends the frames when a placement is given
+    ExifResult<size_t> open(const std::string& filename, uint32_t indexInterval = 256,
+        const ThreadPlacement& placement = ThreadPlacement(), unsigned stream = 0);
+
+    // Appends a frame, with the EXIF blob injected if one is given.
+    // The value of the result is the frame number. After a failed write
+    // every further append fails and close() leaves out the final index.
+    ExifResult<size_t> appendFrame(const uint8_t* jpeg, size_t size, int64_t timestampUs,
+        const uint8_t* exifBlob = nullptr, size_t exifSize = 0, uint32_t flags = 0);
+
+    // Writes the final index and the footer. The value is the frame count.
+    ExifResult<size_t> close();
+
+private:
+    bool writeIndex(size_t first, size_t count, bool periodic);
+
+    FILE* file = nullptr;
+    NodeLocalBuffer writeBuffer;        // Only with a placement
+    uint64_t position = 0;
+    bool failed = false;                // A write failed, the position is unreliable
+    uint64_t lastIndexOffset = 0;
+    size_t indexedFrames = 0;           // Frames covered by the periodic indexes
+    uint32_t indexInterval = 256;
+    std::vector<MjpegFrameInfo> frames;
+    JpegSpliceCache spliceCache;
+};
+
+class MjpegRecordingReader {
+public:
+    // The value of the result is the frame count
+    ExifResult<size_t> open(const std::string& filename);
+    void close();
+
+    size_t frameCount() const { return count; }
+    MjpegFrameInfo frameInfo(size_t frame) const;
+
+    // Points into the mapped file, valid until close()
+    const uint8_t* frameData(size_t frame) const {
+        return file.data() + frameInfo(frame).offset;
+    }
+
+    // Last frame with a timestamp <= timestampUs (0 if all frames are later)
+    size_t findFrameAtTime(int64_t timestampUs) const;
+
+    // True if the footer was missing and the index was rebuilt from the periodic indexes
+    bool recovered() const { return wasRecovered; }
+
+private:
+    ExifResult<size_t> recover();
+
+    MappedFile file;
+    const uint8_t* entries = nullptr;   // Final index in the mapping, or nullptr
+    std::vector<MjpegFrameInfo> recoveredFrames;
+    size_t count = 0;
+    bool wasRecovered = false;
+};
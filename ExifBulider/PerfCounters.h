@@ -0,0 +1,184 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////
+// PerfCounters:
+//
+// Optional hardware counters for the benchmark harness, read through
+// perf_event_open on Linux. Every event is opened on its own, so a missing or
+// forbidden event (perf_event_paranoid, VMs without a PMU) only disables its
+// own column. On other platforms all counters simply report unavailable.
+//
+// Only user-space events of the calling thread are counted.
+//
+enum PerfCounterId {
+    PerfCycles,
+    PerfInstructions,
+    PerfBranchMisses,
+    PerfL1DMisses,
+    PerfLLCMisses,
+    PerfCounterCount
+};
+
+struct PerfSample {
+    uint64_t value[PerfCounterCount] = {};
+    bool valid[PerfCounterCount] = {};
+};
+
+class PerfCounters {
+private:
+    int fds[PerfCounterCount];
+
+public:
+    PerfCounters() {
+        for (int i = 0; i < PerfCounterCount; ++i) {
+            fds[i] = openCounter(static_cast<PerfCounterId>(i));
+        }
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True if at least one counter could be opened
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool available(PerfCounterId id) const {
+        return fds[id] >= 0;
+    }
+
+    static const char* name(PerfCounterId id) {
+        static const char* names[PerfCounterCount] = {
+            "cycles", "instructions", "branch-misses", "L1D-misses", "LLC-misses"
+        };
+        return names[id];
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    PerfSample stop() {
+        PerfSample sample;
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < PerfCounterCount; ++i) {
+            // value, time enabled, time running (PERF_FORMAT_TOTAL_TIME_*)
+            uint64_t data[3] = {};
+            if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+                continue;
+            }
+            // Scale up if the kernel had to multiplex the PMU between events
+            double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+            sample.value[i] = static_cast<uint64_t>(static_cast<double>(data[0]) * scale);
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+
+private:
+    static int openCounter(PerfCounterId id) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (id) {
+        case PerfCycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfInstructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfBranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfL1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfLLCMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            return -1;
+        }
+
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return fd < 0 ? -1 : static_cast<int>(fd);
+#else
+        (void)id;
+        return -1;
+#endif
+    }
+};
@@ -0,0 +1,228 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "ExifDelta.h"
+#include "MicroExif.h"
+#include "MicroExifC.h"
+#include "SelfTest.h"
+
+namespace {
+
+struct CheckLog {
+	size_t passed = 0;
+	size_t failed = 0;
+
+	void check(const std::string& name, bool ok) {
+		printf("%s  %s\n", ok ? "ok  " : "FAIL", name.c_str());
+		++(ok ? passed : failed);
+	}
+};
+
+// Baseline frame with the EXIF segment of the builder behind SOI
+std::vector<uint8_t> makeTaggedJpeg(const ExifBuilder& builder) {
+	std::vector<uint8_t> jpeg = { 0xFF, 0xD8 };
+	std::vector<uint8_t> blob = builder.buildExifBlob();
+	jpeg.insert(jpeg.end(), blob.begin(), blob.end());
+	jpeg.insert(jpeg.end(), { 0xFF, 0xDB, 0x00, 0x43, 0x00 });
+	jpeg.insert(jpeg.end(), 64, 0x02);
+	jpeg.insert(jpeg.end(), { 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x10, 0x00, 0x10, 0x01, 0x01, 0x11, 0x00 });
+	jpeg.insert(jpeg.end(), { 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00 });
+	for (size_t i = 0; i < 6000; ++i) {
+		jpeg.push_back(static_cast<uint8_t>(i * 37 % 251 == 0xFF ? 0 : i * 37 % 251));
+	}
+	jpeg.insert(jpeg.end(), { 0xFF, 0xD9 });
+	return jpeg;
+}
+
+bool writeBytes(const std::string& path, const std::vector<uint8_t>& data) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	return static_cast<bool>(file);
+}
+
+// Creates a delta from a master with the original tags, ships it through
+// encode/decode, applies it twice to an identical replica and checks that
+// the replica then reads back exactly the expected tags
+void checkDelta(CheckLog& log, const std::string& scratch, const char* name, const ExifBuilder& original, const ExifBuilder& edits,
+	const ExifBuilder& expected, ExifDeltaOutcome outcome) {
+	std::string master = scratch + "/microexif_selftest_master.jpg";
+	std::string replica = scratch + "/microexif_selftest_replica.jpg";
+	std::vector<uint8_t> jpeg = makeTaggedJpeg(original);
+	bool ok = writeBytes(master, jpeg) && writeBytes(replica, jpeg);
+
+	ExifDeltaRecord record;
+	ok = ok && createExifDelta(master, edits, record).value != 0;
+	std::vector<uint8_t> encoded;
+	encodeExifDelta(record, encoded);
+	ExifDeltaRecord shipped;
+	auto decoded = decodeExifDelta(encoded.data(), encoded.size(), shipped);
+	ok = ok && decoded && decoded.value == encoded.size();
+
+	auto first = applyExifDelta(shipped, replica);
+	auto second = applyExifDelta(shipped, replica);
+	ExifDeltaRecord remaining;
+	auto readBack = createExifDelta(replica, expected, remaining);
+	std::string suffix = std::string(" (") + name + ")";
+	log.check("delta applied" + suffix, ok && first && first.value == outcome);
+	log.check("delta applied twice" + suffix, second && second.value == ExifDeltaOutcome::AlreadyApplied);
+	log.check("delta read back" + suffix, readBack && readBack.value == 0);
+
+	std::error_code error;
+	std::filesystem::remove(master, error);
+	std::filesystem::remove(replica, error);
+}
+
+void checkDeltas(CheckLog& log, const std::string& scratch) {
+	const std::string longArtist = "A long artist name";
+	const std::string longCopyright = "2026 Vlad Erium, Japan";
+
+	ExifBuilder longTags;
+	longTags.addTag(ExifTag(0x010F, 0x0002, "Ximea"));
+	longTags.addTag(ExifTag(0x0112, 0x0003, 1, uint16_t(1)));
+	longTags.addTag(ExifTag(0x013B, 0x0002, longArtist));
+	ExifBuilder shortTags;
+	shortTags.addTag(ExifTag(0x010F, 0x0002, "Ximea"));
+	shortTags.addTag(ExifTag(0x0112, 0x0003, 1, uint16_t(1)));
+	shortTags.addTag(ExifTag(0x013B, 0x0002, "abc"));
+
+	// An out-of-line value shrunk into the IFD entry, in place
+	ExifBuilder shrink;
+	shrink.addTag(ExifTag(0x013B, 0x0002, "abc"));
+	checkDelta(log, scratch, "shrink", longTags, shrink, shortTags, ExifDeltaOutcome::InPlace);
+
+	// An in-entry value grown out of line
+	ExifBuilder grow;
+	grow.addTag(ExifTag(0x013B, 0x0002, longArtist));
+	checkDelta(log, scratch, "grow", shortTags, grow, longTags, ExifDeltaOutcome::Rewritten);
+
+	// A tag that did not exist
+	ExifBuilder added;
+	added.addTag(ExifTag(0x8298, 0x0002, longCopyright));
+	ExifBuilder withCopyright;
+	withCopyright.addTag(ExifTag(0x010F, 0x0002, "Ximea"));
+	withCopyright.addTag(ExifTag(0x013B, 0x0002, longArtist));
+	withCopyright.addTag(ExifTag(0x8298, 0x0002, longCopyright));
+	checkDelta(log, scratch, "new tag", longTags, added, withCopyright, ExifDeltaOutcome::Rewritten);
+
+	// Shrink and new tag together, so the shrunk value goes through the rewrite
+	ExifBuilder mixed;
+	mixed.addTag(ExifTag(0x013B, 0x0002, "abc"));
+	mixed.addTag(ExifTag(0x0112, 0x0003, 1, uint16_t(6)));
+	mixed.addTag(ExifTag(0x8298, 0x0002, longCopyright));
+	ExifBuilder mixedResult;
+	mixedResult.addTag(ExifTag(0x010F, 0x0002, "Ximea"));
+	mixedResult.addTag(ExifTag(0x0112, 0x0003, 1, uint16_t(6)));
+	mixedResult.addTag(ExifTag(0x013B, 0x0002, "abc"));
+	mixedResult.addTag(ExifTag(0x8298, 0x0002, longCopyright));
+	checkDelta(log, scratch, "shrink and new tag", longTags, mixed, mixedResult, ExifDeltaOutcome::Rewritten);
+}
+
+#ifdef __linux__
+
+// Feeds the chunks as separate reads (one datagram per read) into
+// mexif_inject_fd and returns what it wrote
+mexif_status injectChunks(const std::string& output, const std::vector<std::vector<uint8_t>>& chunks,
+	const uint8_t* blob, size_t blobSize, std::vector<uint8_t>& result) {
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0) {
+		return MEXIF_E_IO;
+	}
+	for (const auto& chunk : chunks) {
+		if (write(sockets[1], chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+			close(sockets[0]);
+			close(sockets[1]);
+			return MEXIF_E_IO;
+		}
+	}
+	close(sockets[1]);
+	int out = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	mexif_status status = out < 0 ? MEXIF_E_IO : mexif_inject_fd(sockets[0], out, blob, blobSize);
+	close(sockets[0]);
+	if (out >= 0) {
+		close(out);
+	}
+	std::ifstream file(output, std::ios::binary);
+	result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return status;
+}
+
+// Every split of a small JPEG into two and three reads must give the same
+// output as the in-memory injection, including splits inside SOI and DQT
+void checkInjectFd(CheckLog& log, const std::string& scratch) {
+	const std::vector<uint8_t> jpeg = { 0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x04, 0xAA, 0xFF, 0xFF, 0xDB, 0x00, 0x03, 0x01, 0xFF, 0xD9 };
+	const uint8_t blob[] = { 0xFF, 0xE1, 0x00, 0x04, 0x12, 0x34 };
+	std::vector<uint8_t> expected(jpeg.size() + sizeof(blob));
+	size_t expectedSize = 0;
+	bool ok = mexif_inject_into(jpeg.data(), jpeg.size(), blob, sizeof(blob), expected.data(), expected.size(), &expectedSize) == MEXIF_OK;
+
+	std::string output = scratch + "/microexif_selftest_fd.jpg";
+	size_t splits = 0;
+	size_t mismatches = 0;
+	for (size_t first = 1; ok && first < jpeg.size(); ++first) {
+		for (size_t second = first; second < jpeg.size(); ++second) {
+			std::vector<std::vector<uint8_t>> chunks;
+			chunks.emplace_back(jpeg.begin(), jpeg.begin() + first);
+			if (second > first) {
+				chunks.emplace_back(jpeg.begin() + first, jpeg.begin() + second);
+			}
+			chunks.emplace_back(jpeg.begin() + second, jpeg.end());
+			std::vector<uint8_t> result;
+			mexif_status status = injectChunks(output, chunks, blob, sizeof(blob), result);
+			++splits;
+			if (status != MEXIF_OK || result != expected) {
+				++mismatches;
+			}
+		}
+	}
+	std::error_code error;
+	std::filesystem::remove(output, error);
+	log.check("mexif_inject_fd chunk boundaries (" + std::to_string(splits) + " splits)", ok && mismatches == 0);
+}
+
+#endif
+
+} // namespace
+
+int selfTestMain(int argc, char* argv[]) {
+	std::string scratch = argc > 0 ? argv[0] : std::filesystem::temp_directory_path().string();
+	CheckLog log;
+	checkDeltas(log, scratch);
+#ifdef __linux__
+	checkInjectFd(log, scratch);
+#endif
+	printf("%zu checks passed, %zu failed\n", log.passed, log.failed);
+	return log.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "BatchTagger.h"
+#include "StorageTuner.h"
+
+namespace {
+
+// Tags the samples repeatedly until the time is up (at least once) and
+// returns the files tagged per second
+double measure(const std::string& scratch, const std::vector<std::string>& samples, const uint8_t* exifBlob, size_t exifSize,
+	IoBackend backend, unsigned workers, double seconds) {
+	BatchOptions options;
+	options.workers = workers;
+	options.backend = backend;
+	options.queueDepth = std::max<size_t>(16, workers * 4);   // Little backlog after the time is up
+
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0.0;
+	size_t files = 0;
+	BatchTagger tagger(exifBlob, exifSize, options);
+	do {
+		// Distinct names, so no two workers write the same file
+		for (size_t i = 0; i < samples.size(); ++i) {
+			tagger.submit(samples[i], scratch + "/" + std::to_string(files + i) + ".jpg");
+		}
+		files += samples.size();
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < seconds);
+	BatchStats stats = tagger.finish();
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::error_code error;
+	for (size_t i = 0; i < files; ++i) {
+		std::filesystem::remove(scratch + "/" + std::to_string(i) + ".jpg", error);
+	}
+	return elapsed > 0.0 ? static_cast<double>(stats.tagged) / elapsed : 0.0;
+}
+
+} // namespace
+
+uint64_t storageDeviceId(const std::string& path) {
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(info.st_dev);
+}
+
+StorageProfile StorageTuner::calibrate(const std::string& outputDir, const std::vector<std::string>& samples,
+	const uint8_t* exifBlob, size_t exifSize, double budgetSeconds) {
+	StorageProfile profile;
+	std::error_code error;
+	std::filesystem::create_directories(outputDir, error);
+	profile.device = storageDeviceId(outputDir);
+	if (samples.empty()) {
+		return profile;
+	}
+
+	std::string scratch = outputDir + "/.microexif-probe";
+	std::filesystem::create_directories(scratch, error);
+
+	// Samples that cannot be tagged at all (not a JPEG, unreadable) would only
+	// count as failures in every run, so they are left out
+	std::vector<std::string> usable;
+	std::string target = scratch + "/check.jpg";
+	for (const auto& sample : samples) {
+		if (tryWriteNewJpegWithExif(sample, target, exifBlob, exifSize)) {
+			usable.push_back(sample);
+		}
+	}
+	std::filesystem::remove(target, error);
+	if (usable.empty()) {
+		std::filesystem::remove_all(scratch, error);
+		return profile;
+	}
+
+	// Half of the budget picks the backend, the other half the worker count
+	std::vector<IoBackend> backends;
+	for (size_t i = 0; i < ioBackendCount; ++i) {
+		if (ioBackendAvailable(static_cast<IoBackend>(i))) {
+			backends.push_back(static_cast<IoBackend>(i));
+		}
+	}
+	unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	unsigned baseWorkers = std::min(4u, cores);
+	double share = budgetSeconds / 2.0 / static_cast<double>(backends.size());
+	for (IoBackend backend : backends) {
+		double rate = measure(scratch, usable, exifBlob, exifSize, backend, baseWorkers, share);
+		if (rate > profile.filesPerSecond) {
+			profile.backend = backend;
+			profile.filesPerSecond = rate;
+			profile.workers = baseWorkers;
+		}
+	}
+
+	// Network and RAID volumes often want more requests in flight than cores
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned workers = baseWorkers * 2; workers <= cores * 4; workers *= 2) {
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > budgetSeconds / 2.0) {
+			break;
+		}
+		double rate = measure(scratch, usable, exifBlob, exifSize, profile.backend, workers, budgetSeconds / 8.0);
+		if (rate < profile.filesPerSecond * 1.05) {
+			break;
+		}
+		profile.workers = workers;
+		profile.filesPerSecond = rate;
+	}
+
+	std::filesystem::remove_all(scratch, error);
+	return profile;
+}
+
+StorageProfile StorageTuner::profileFor(const std::string& outputDir, const std::vector<std::string>& samples,
+	const uint8_t* exifBlob, size_t exifSize, bool recalibrate) {
+	std::error_code error;
+	std::filesystem::create_directories(outputDir, error);
+	uint64_t device = storageDeviceId(outputDir);
+	auto cached = std::find_if(profiles.begin(), profiles.end(), [&](const StorageProfile& profile) { return profile.device == device; });
+	if (cached != profiles.end() && !recalibrate) {
+		return *cached;
+	}
+
+	StorageProfile profile = calibrate(outputDir, samples, exifBlob, exifSize);
+	if (profile.filesPerSecond > 0.0) {
+		if (cached != profiles.end()) {
+			*cached = profile;
+		}
+		else {
+			profiles.push_back(profile);
+		}
+		save();
+	}
+	return profile;
+}
+
+bool StorageTuner::load() {
+	profiles.clear();
+	std::ifstream file(cachePath);
+	if (!file) {
+		return false;
+	}
+	StorageProfile profile;
+	std::string backend;
+	while (file >> profile.device >> backend >> profile.workers >> profile.filesPerSecond) {
+		if (parseIoBackend(backend, profile.backend) && ioBackendAvailable(profile.backend) && profile.workers > 0) {
+			profiles.push_back(profile);
+		}
+	}
+	return true;
+}
+
+bool StorageTuner::save() const {
+	std::error_code error;
+	std::filesystem::path directory = std::filesystem::path(cachePath).parent_path();
+	if (!directory.empty()) {
+		std::filesystem::create_directories(directory, error);
+	}
+	std::ofstream file(cachePath, std::ios::trunc);
+	for (const auto& profile : profiles) {
+		file << profile.device << ' ' << ioBackendName(profile.backend) << ' ' << profile.workers << ' ' << profile.filesPerSecond << '\n';
+	}
+	return static_cast<bool>(file);
+}
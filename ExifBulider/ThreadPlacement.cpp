@@ -0,0 +1,296 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ThreadPlacement.h"
+
+namespace {
+
+bool parseNumber(const std::string& text, unsigned& value) {
+	if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos) {
+		return false;
+	}
+	value = static_cast<unsigned>(std::stoul(text));
+	return true;
+}
+
+#ifdef __linux__
+std::string readFirstLine(const std::string& path) {
+	std::ifstream file(path);
+	std::string line;
+	std::getline(file, line);
+	return line;
+}
+#endif
+
+} // namespace
+
+bool parseCpuList(const std::string& list, std::vector<unsigned>& cpus) {
+	cpus.clear();
+	std::stringstream stream(list);
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		while (!range.empty() && (range.back() == '\n' || range.back() == ' ')) {
+			range.pop_back();
+		}
+		if (range.empty()) {
+			continue;
+		}
+		size_t dash = range.find('-');
+		unsigned first = 0;
+		unsigned last = 0;
+		if (dash == std::string::npos) {
+			if (!parseNumber(range, first)) {
+				return false;
+			}
+			last = first;
+		}
+		else if (!parseNumber(range.substr(0, dash), first) || !parseNumber(range.substr(dash + 1), last) || last < first) {
+			return false;
+		}
+		for (unsigned cpu = first; cpu <= last; ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	return !cpus.empty();
+}
+
+bool ThreadPlacement::parse(const std::string& spec, ThreadPlacement& placement) {
+	placement = ThreadPlacement();
+	if (spec.empty() || spec == "none") {
+		return true;
+	}
+	if (spec == "spread") {
+		placement.mode = Mode::Spread;
+		return true;
+	}
+	if (spec.compare(0, 5, "node:") == 0) {
+		placement.mode = Mode::Node;
+		return parseNumber(spec.substr(5), placement.node);
+	}
+	if (spec.compare(0, 5, "cpus:") == 0) {
+		placement.mode = Mode::Cpus;
+		return parseCpuList(spec.substr(5), placement.cpus);
+	}
+	return false;
+}
+
+size_t numaNodeCount() {
+#ifdef _WIN32
+	ULONG highest = 0;
+	return GetNumaHighestNodeNumber(&highest) ? highest + 1 : 1;
+#elif defined(__linux__)
+	std::vector<unsigned> nodes;
+	if (!parseCpuList(readFirstLine("/sys/devices/system/node/online"), nodes)) {
+		return 1;
+	}
+	return nodes.back() + 1;
+#else
+	return 1;
+#endif
+}
+
+std::vector<unsigned> numaNodeCpus(unsigned node) {
+	std::vector<unsigned> cpus;
+#ifdef _WIN32
+	GROUP_AFFINITY affinity;
+	if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)) {
+		for (unsigned cpu = 0; cpu < sizeof(KAFFINITY) * 8; ++cpu) {
+			if (affinity.Mask & (KAFFINITY(1) << cpu)) {
+				cpus.push_back(affinity.Group * 64 + cpu);
+			}
+		}
+	}
+#elif defined(__linux__)
+	parseCpuList(readFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"), cpus);
+#else
+	(void)node;
+#endif
+	return cpus;
+}
+
+unsigned currentNumaNode() {
+#ifdef _WIN32
+	PROCESSOR_NUMBER processor;
+	GetCurrentProcessorNumberEx(&processor);
+	USHORT node = 0;
+	return GetNumaProcessorNodeEx(&processor, &node) ? node : 0;
+#elif defined(__linux__)
+	unsigned cpu = 0;
+	unsigned node = 0;
+	return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? node : 0;
+#else
+	return 0;
+#endif
+}
+
+bool pinCurrentThread(const std::vector<unsigned>& cpus) {
+	if (cpus.empty()) {
+		return false;
+	}
+#ifdef _WIN32
+	// Processor groups: all CPUs must be in the group of the first one
+	GROUP_AFFINITY affinity = {};
+	affinity.Group = static_cast<WORD>(cpus[0] / 64);
+	for (unsigned cpu : cpus) {
+		if (cpu / 64 == affinity.Group) {
+			affinity.Mask |= KAFFINITY(1) << (cpu % 64);
+		}
+	}
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (unsigned cpu : cpus) {
+		if (cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+bool applyThreadPlacement(const ThreadPlacement& placement, unsigned index) {
+	switch (placement.mode) {
+	case ThreadPlacement::Mode::None:
+		return true;
+	case ThreadPlacement::Mode::Node:
+		return pinCurrentThread(numaNodeCpus(placement.node));
+	case ThreadPlacement::Mode::Spread:
+		return pinCurrentThread(numaNodeCpus(static_cast<unsigned>(index % numaNodeCount())));
+	case ThreadPlacement::Mode::Cpus:
+		return !placement.cpus.empty() && pinCurrentThread({ placement.cpus[index % placement.cpus.size()] });
+	}
+	return false;
+}
+
+bool NodeLocalBuffer::allocate(size_t size, unsigned node) {
+	release();
+	if (size == 0) {
+		return false;
+	}
+#ifdef _WIN32
+	void* memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+	if (!memory) {
+		return false;
+	}
+#elif defined(__linux__)
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return false;
+	}
+	// MPOL_PREFERRED: use the node while it has free memory. Without NUMA
+	// support the call fails and first touch decides.
+	unsigned long mask[16] = {};
+	if (node < sizeof(mask) * 8) {
+		mask[node / (sizeof(unsigned long) * 8)] = 1ul << (node % (sizeof(unsigned long) * 8));
+		syscall(SYS_mbind, memory, size, 1, mask, sizeof(mask) * 8, 0);
+	}
+#else
+	(void)node;
+	void* memory = ::operator new(size, std::nothrow);
+	if (!memory) {
+		return false;
+	}
+#endif
+	buffer = static_cast<uint8_t*>(memory);
+	bufferSize = size;
+	// One write per page so the pages exist before the hot path
+	for (size_t offset = 0; offset < size; offset += 4096) {
+		buffer[offset] = 0;
+	}
+	return true;
+}
+
+void NodeLocalBuffer::release() {
+	if (buffer) {
+#ifdef _WIN32
+		VirtualFree(buffer, 0, MEM_RELEASE);
+#elif defined(__linux__)
+		munmap(buffer, bufferSize);
+#else
+		::operator delete(buffer);
+#endif
+	}
+	buffer = nullptr;
+	bufferSize = 0;
+}
+
+NumaCounters NumaCounters::operator-(const NumaCounters& other) const {
+	NumaCounters delta;
+	delta.hit = hit - other.hit;
+	delta.miss = miss - other.miss;
+	delta.localNode = localNode - other.localNode;
+	delta.otherNode = otherNode - other.otherNode;
+	return delta;
+}
+
+bool NumaCounters::read(NumaCounters& counters) {
+	counters = NumaCounters();
+#ifdef __linux__
+	bool found = false;
+	size_t nodes = numaNodeCount();
+	for (size_t node = 0; node < nodes; ++node) {
+		std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/numastat");
+		std::string name;
+		uint64_t value = 0;
+		while (file >> name >> value) {
+			found = true;
+			if (name == "numa_hit") {
+				counters.hit += value;
+			}
+			else if (name == "numa_miss") {
+				counters.miss += value;
+			}
+			else if (name == "local_node") {
+				counters.localNode += value;
+			}
+			else if (name == "other_node") {
+				counters.otherNode += value;
+			}
+		}
+	}
+	return found;
+#else
+	return false;
+#endif
+}
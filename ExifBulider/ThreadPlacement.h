@@ -0,0 +1,119 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////
+// Thread placement:
+//
+// Pins pipeline threads to cores or NUMA nodes so that a stage keeps running
+// next to its frame buffers. A placement is parsed from a short spec:
+//
+//   none          Threads are not pinned (default)
+//   node:N        All threads of the stage run on the CPUs of node N
+//   spread        Thread i runs on the CPUs of node i % nodes
+//   cpus:0-3,8    Thread i runs on the i-th CPU of the list (wrapping)
+//
+// Each camera stream or batch stage has its own placement; every thread
+// calls applyThreadPlacement() with its index when it starts. Memory a
+// pinned thread touches first is allocated on its node by the kernel, and
+// NodeLocalBuffer additionally sets a preferred-node policy for large
+// buffers. Node topology comes from /sys/devices/system/node on Linux and
+// from the processor group APIs on Windows.
+//
+struct ThreadPlacement {
+    enum class Mode : uint8_t {
+        None,
+        Node,
+        Spread,
+        Cpus
+    };
+
+    Mode mode = Mode::None;
+    unsigned node = 0;
+    std::vector<unsigned> cpus;
+
+    // Returns false for an invalid spec
+    static bool parse(const std::string& spec, ThreadPlacement& placement);
+};
+
+// Parses a Linux cpulist ("0-3,8,10-11")
+bool parseCpuList(const std::string& list, std::vector<unsigned>& cpus);
+
+size_t numaNodeCount();
+std::vector<unsigned> numaNodeCpus(unsigned node);
+// Node of the CPU the calling thread runs on, 0 if unknown
+unsigned currentNumaNode();
+
+// Restricts the calling thread to the given CPUs
+bool pinCurrentThread(const std::vector<unsigned>& cpus);
+// Pins the calling thread, the index-th thread of its stage. Returns true if
+// the placement is None or was applied.
+bool applyThreadPlacement(const ThreadPlacement& placement, unsigned index);
+
+// Page-aligned buffer preferring the memory of one NUMA node, touched once
+// so the pages are allocated before the hot path uses them
+class NodeLocalBuffer {
+public:
+    NodeLocalBuffer() = default;
+    NodeLocalBuffer(size_t size, unsigned node) {
+        allocate(size, node);
+    }
+    ~NodeLocalBuffer() {
+        release();
+    }
+
+    NodeLocalBuffer(const NodeLocalBuffer&) = delete;
+    NodeLocalBuffer& operator=(const NodeLocalBuffer&) = delete;
+
+    bool allocate(size_t size, unsigned node);
+    void release();
+
+    uint8_t* data() const { return buffer; }
+    size_t size() const { return bufferSize; }
+
+private:
+    uint8_t* buffer = nullptr;
+    size_t bufferSize = 0;
+};
+
+// System-wide NUMA allocation counters in pages, summed over all nodes
+// (numastat). remote() counts pages that were placed on another node than
+// the one the allocating thread ran on.
+struct NumaCounters {
+    uint64_t hit = 0;           // Allocated on the intended node
+    uint64_t miss = 0;          // Allocated elsewhere because the intended node was full
+    uint64_t localNode = 0;     // Allocated on the node of the allocating thread
+    uint64_t otherNode = 0;     // Allocated on another node
+
+    uint64_t remote() const { return otherNode; }
+    NumaCounters operator-(const NumaCounters& other) const;
+
+    // Returns false if the counters are not available
+    static bool read(NumaCounters& counters);
+};
@@ -0,0 +1,283 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TiffAppender.h"
+
+namespace {
+
+bool pwriteAll(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+#ifdef _WIN32
+	if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+		return false;
+	}
+	while (size > 0) {
+		int n = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30)));
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+	return true;
+#else
+	while (size > 0) {
+		ssize_t n = pwrite(fd, data, size, static_cast<off_t>(offset));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+		offset += static_cast<uint64_t>(n);
+	}
+	return true;
+#endif
+}
+
+bool preadAll(int fd, uint8_t* data, size_t size, uint64_t offset) {
+#ifdef _WIN32
+	if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+		return false;
+	}
+	return _read(fd, data, static_cast<unsigned int>(size)) == static_cast<int>(size);
+#else
+	while (size > 0) {
+		ssize_t n = pread(fd, data, size, static_cast<off_t>(offset));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+		offset += static_cast<uint64_t>(n);
+	}
+	return true;
+#endif
+}
+
+uint32_t getUInt32(const uint8_t* src, bool bigendian) {
+	if (bigendian) {
+		return (static_cast<uint32_t>(src[0]) << 24) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 8) | src[3];
+	}
+	return (static_cast<uint32_t>(src[3]) << 24) | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[1]) << 8) | src[0];
+}
+
+uint16_t getUInt16(const uint8_t* src, bool bigendian) {
+	return static_cast<uint16_t>(bigendian ? (src[0] << 8) | src[1] : (src[1] << 8) | src[0]);
+}
+
+} // namespace
+
+ExifResult<size_t> TiffAppender::open(const std::string& filename, bool bigendianIfNew) {
+	close();
+#ifdef _WIN32
+	fd = _open(filename.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+	if (fd < 0) {
+		return ExifResult<size_t>::failure(ExifError::OpenFailed);
+	}
+
+#ifdef _WIN32
+	fileSize = static_cast<uint64_t>(_lseeki64(fd, 0, SEEK_END));
+#else
+	struct stat info;
+	fileSize = fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+	pages = 0;
+	nextPointerOffset = 4;
+
+	if (fileSize == 0) {
+		// New file: TIFF header without a first IFD yet
+		bigendian = bigendianIfNew;
+		uint8_t header[8] = {};
+		ExifBuilder::putUInt16(header, bigendian ? 0x4D4D : 0x4949, true);
+		ExifBuilder::putUInt16(header + 2, 0x002A, bigendian);
+		if (!pwriteAll(fd, header, sizeof(header), 0)) {
+			close();
+			return ExifResult<size_t>::failure(ExifError::WriteFailed);
+		}
+		fileSize = sizeof(header);
+		return ExifResult<size_t>::success(0);
+	}
+
+	ExifError error = findLastPage();
+	if (error != ExifError::None) {
+		close();
+		return ExifResult<size_t>::failure(error, static_cast<size_t>(nextPointerOffset));
+	}
+	return ExifResult<size_t>::success(pages);
+}
+
+// Walks the IFD chain of an existing file to the last next-IFD pointer
+ExifError TiffAppender::findLastPage() {
+	uint8_t header[8];
+	if (fileSize < 8 || !preadAll(fd, header, 8, 0)) {
+		return ExifError::Truncated;
+	}
+	if (header[0] == 'M' && header[1] == 'M') {
+		bigendian = true;
+	}
+	else if (header[0] == 'I' && header[1] == 'I') {
+		bigendian = false;
+	}
+	else {
+		return ExifError::Malformed;
+	}
+	if (getUInt16(header + 2, bigendian) != 0x002A) {
+		return ExifError::Malformed;
+	}
+
+	uint32_t offset = getUInt32(header + 4, bigendian);
+	while (offset != 0) {
+		// Every IFD is at least 6 bytes, more pages than that means a loop
+		if (offset + 2ull > fileSize || pages > fileSize / 6) {
+			return ExifError::Malformed;
+		}
+		uint8_t count[2];
+		if (!preadAll(fd, count, 2, offset)) {
+			return ExifError::Truncated;
+		}
+		nextPointerOffset = offset + 2ull + getUInt16(count, bigendian) * 12ull;
+		uint8_t next[4];
+		if (nextPointerOffset + 4 > fileSize || !preadAll(fd, next, 4, nextPointerOffset)) {
+			return ExifError::Truncated;
+		}
+		offset = getUInt32(next, bigendian);
+		++pages;
+	}
+	return ExifError::None;
+}
+
+void TiffAppender::close() {
+	if (fd >= 0) {
+#ifdef _WIN32
+		_close(fd);
+#else
+		::close(fd);
+#endif
+	}
+	fd = -1;
+	pages = 0;
+}
+
+ExifResult<size_t> TiffAppender::appendPage(const TiffPage& page, const std::vector<ExifTag>& tags) {
+	if (fd < 0) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed);
+	}
+	if (page.bitsPerSample != 8 && page.bitsPerSample != 16) {
+		return ExifResult<size_t>::failure(ExifError::Malformed);
+	}
+	uint64_t expectedSize = static_cast<uint64_t>(page.width) * page.height * page.samplesPerPixel * (page.bitsPerSample / 8);
+	if (!page.data || page.size != expectedSize || page.size == 0 || page.size > UINT32_MAX) {
+		return ExifResult<size_t>::failure(ExifError::Malformed);
+	}
+	// BitsPerSample below holds at most four samples
+	if (page.samplesPerPixel == 0 || page.samplesPerPixel > 4) {
+		return ExifResult<size_t>::failure(ExifError::TooLarge);
+	}
+
+	// Image data and IFD both start on a word boundary
+	uint64_t dataOffset = (fileSize + 1) & ~1ull;
+	uint64_t ifdOffset = (dataOffset + page.size + 1) & ~1ull;
+
+	// Baseline tags first, the page tags may not replace them
+	ExifBuilder builder;
+	uint32_t width = page.width;
+	uint32_t height = page.height;
+	uint32_t stripOffset = static_cast<uint32_t>(dataOffset);
+	uint32_t stripSize = static_cast<uint32_t>(page.size);
+	uint16_t bits[4] = { page.bitsPerSample, page.bitsPerSample, page.bitsPerSample, page.bitsPerSample };
+	uint16_t compression = 1;
+	uint16_t photometric = page.samplesPerPixel >= 3 ? 2 : 1;
+	uint16_t planar = 1;
+	builder.setTagValue(0x0100, 0x0004, 1, &width, 4);                 // ImageWidth
+	builder.setTagValue(0x0101, 0x0004, 1, &height, 4);                // ImageLength
+	builder.setTagValue(0x0102, 0x0003, page.samplesPerPixel, bits, page.samplesPerPixel * 2u);   // BitsPerSample
+	builder.setTagValue(0x0103, 0x0003, 1, &compression, 2);           // Compression: none
+	builder.setTagValue(0x0106, 0x0003, 1, &photometric, 2);           // PhotometricInterpretation
+	builder.setTagValue(0x0111, 0x0004, 1, &stripOffset, 4);           // StripOffsets
+	builder.setTagValue(0x0115, 0x0003, 1, &page.samplesPerPixel, 2);  // SamplesPerPixel
+	builder.setTagValue(0x0116, 0x0004, 1, &height, 4);                // RowsPerStrip
+	builder.setTagValue(0x0117, 0x0004, 1, &stripSize, 4);             // StripByteCounts
+	builder.setTagValue(0x011C, 0x0003, 1, &planar, 2);                // PlanarConfiguration: chunky
+	for (const auto& tag : tags) {
+		if (!builder.findTag(tag.tag)) {
+			builder.addTag(ExifTag(tag));
+		}
+	}
+
+	std::vector<ExifTag> ifdTags = builder.getTags();
+	std::sort(ifdTags.begin(), ifdTags.end(), [](const ExifTag& a, const ExifTag& b) { return a.tag < b.tag; });
+
+	size_t ifdSize = ExifBuilder::ifdSize(ifdTags);
+	if (ifdTags.size() > 0xFFFF || ifdOffset + ifdSize > UINT32_MAX) {
+		return ExifResult<size_t>::failure(ExifError::TooLarge);
+	}
+
+	ifd.assign(ifdSize, 0);
+	ExifBuilder::writeIfdAt(ifd.data(), static_cast<uint32_t>(ifdOffset), ifdTags, 0, bigendian);
+
+	const uint8_t* pixels = page.data;
+	if (page.bitsPerSample == 16 && bigendian != (std::endian::native == std::endian::big)) {
+		swapped.resize(page.size);
+		for (size_t i = 0; i < page.size; i += 2) {
+			swapped[i] = page.data[i + 1];
+			swapped[i + 1] = page.data[i];
+		}
+		pixels = swapped.data();
+	}
+
+	uint8_t pointer[4];
+	ExifBuilder::putUInt32(pointer, static_cast<uint32_t>(ifdOffset), bigendian);
+	if (!pwriteAll(fd, pixels, page.size, dataOffset)
+		|| !pwriteAll(fd, ifd.data(), ifd.size(), ifdOffset)
+		|| !pwriteAll(fd, pointer, 4, nextPointerOffset)) {
+		return ExifResult<size_t>::failure(ExifError::WriteFailed, static_cast<size_t>(dataOffset));
+	}
+
+	nextPointerOffset = ifdOffset + 2 + ifdTags.size() * 12;
+	fileSize = ifdOffset + ifdSize;
+	return ExifResult<size_t>::success(pages++);
+}
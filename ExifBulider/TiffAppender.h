@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2025 Erium Vladlen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MicroExif.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+// TiffAppender:
+//
+// Streaming writer for multi-page TIFF files (time-lapse, z-stacks). Each
+// appendPage() writes the uncompressed image data and the page IFD at the
+// end of the file, then patches the 4-byte next-IFD pointer of the previous
+// page with a single positioned write. Appending therefore costs O(page)
+// no matter how many pages the file already has, and a reader never sees a
+// page before its data and IFD are complete.
+//
+// Opening an existing file walks its IFD chain once to find the last page.
+// IFDs are laid out by ExifBuilder::writeIfdAt(); the baseline tags
+// (dimensions, strip, photometric interpretation) are added automatically
+// and the page tags are merged in, sorted by tag ID as TIFF requires.
+// 16-bit samples are converted from host order to the byte order of the file.
+//
+struct TiffPage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t samplesPerPixel = 1;       // 1 = grayscale, 3 = RGB
+    uint16_t bitsPerSample = 8;         // 8 or 16
+    const uint8_t* data = nullptr;      // Chunky pixels, rows top to bottom, 16-bit samples in host order
+    size_t size = 0;
+};
+
+class TiffAppender {
+public:
+    TiffAppender() = default;
+    ~TiffAppender() {
+        close();
+    }
+
+    TiffAppender(const TiffAppender&) = delete;
+    TiffAppender& operator=(const TiffAppender&) = delete;
+
+    // Opens filename for appending, creating it with the given byte order if
+    // it does not exist. The value of the result is the number of pages.
+    ExifResult<size_t> open(const std::string& filename, bool bigendian = true);
+    void close();
+
+    // Appends a page with additional tags (e.g. DateTime, Make, Model).
+    // The value of the result is the page number.
+    ExifResult<size_t> appendPage(const TiffPage& page, const std::vector<ExifTag>& tags = std::vector<ExifTag>());
+
+    size_t pageCount() const { return pages; }
+
+private:
+    ExifError findLastPage();
+
+    int fd = -1;
+    bool bigendian = true;
+    uint64_t fileSize = 0;
+    uint64_t nextPointerOffset = 4;     // Where the offset of the next IFD goes
+    size_t pages = 0;
+    std::vector<uint8_t> ifd;           // Reused IFD buffer
+    std::vector<uint8_t> swapped;       // Reused buffer for 16-bit samples in file order
+};